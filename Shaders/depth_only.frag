@@ -0,0 +1,6 @@
+#version 450
+
+// Depth is written by fixed function, no color attachments
+void main()
+{
+}
@@ -0,0 +1,12 @@
+#version 450
+
+// Only position is fetched, from its own stream if model has split positions
+layout(location = 0) in vec3 position;
+
+layout(push_constant) uniform Push{
+	mat4 modelViewProjection;
+}push;
+
+void main(){
+	gl_Position = push.modelViewProjection * vec4(position, 1.0);
+}
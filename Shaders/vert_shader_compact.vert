@@ -0,0 +1,44 @@
+#version 450
+
+// Position is unorm16 in model bounds, push.modelMatrix includes dequantization
+layout(location = 0) in vec3 position;
+// Octahedral encoded normal
+layout(location = 2) in vec2 normal;
+layout(location = 3) in vec2 texCord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCord;
+
+layout(push_constant) uniform Push{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	int hasTexture;
+}push;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projectionMatrix;
+  mat4 viewMatrix;
+  vec4 ambientLight;
+  vec4 lightPosition;
+  vec4 lightColor;
+} ubo;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+void main(){
+	vec4 vertexPosition = push.modelMatrix * vec4(position, 1.0);
+	gl_Position = ubo.projectionMatrix * ubo.viewMatrix * vertexPosition;
+
+	fragNormalWorld = normalize(mat3(push.normalMatrix) * DecodeOctahedral(normal));
+	fragPosWorld = vertexPosition.xyz;
+	fragColor = vec3(1.0);
+	fragTexCord = texCord;
+}
@@ -0,0 +1,90 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <variant>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "Image.hpp"
+
+namespace VulkanEngine
+{
+    static void PrintStatistics(const MemoryAllocator::Statistics& statistics)
+    {
+        constexpr double MB = 1024.0 * 1024.0;
+        std::cout << "  blocks: " << statistics.blockCount << " (" << statistics.blockBytes / MB << " MB)"
+            << ", dedicated: " << statistics.dedicatedAllocationCount << " (" << statistics.dedicatedBytes / MB
+            << " MB)"
+            << ", resources: " << statistics.allocationCount
+            << "\n  used: " << statistics.usedBytes / MB << " MB"
+            << ", free: " << statistics.freeBytes / MB << " MB in " << statistics.freeRegionCount << " regions"
+            << ", largest free region: " << statistics.largestFreeRegion / MB << " MB"
+            << ", fragmentation: " << statistics.fragmentation << std::endl;
+    }
+
+    void RunAllocatorStress(uint32_t iterations)
+    {
+        Device device{};
+        using Resource = std::variant<std::unique_ptr<Buffer>, std::unique_ptr<Image>>;
+        std::vector<Resource> resources;
+
+        // Fixed seed, so runs are comparable
+        std::mt19937 random{42};
+        std::uniform_real_distribution<double> logSize{8.0, 22.0};
+        const VkBufferUsageFlags bufferUsages[] = {
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT};
+
+        VkSamplerCreateInfo samplerInfo{};
+        Image::DefaultSamplerCreateInfo(samplerInfo, device);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            // Grow to steady state first, then keep creating and destroying in random order.
+            bool create = resources.empty() || (resources.size() < 2000 && random() % 100 < 60);
+            if (!create)
+            {
+                size_t index = random() % resources.size();
+                std::swap(resources[index], resources.back());
+                resources.pop_back();
+                continue;
+            }
+
+            if (random() % 4 == 0)
+            {
+                int extent = 16 << (random() % 7);
+                VkImageCreateInfo imageInfo{};
+                Image::DefaultImageCreateInfo(imageInfo, extent, extent, VK_FORMAT_R8G8B8A8_UNORM,
+                                              VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+                resources.emplace_back(std::make_unique<Image>(device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                               Device::defaultSubresourceRange, samplerInfo));
+            }
+            else
+            {
+                auto size = static_cast<VkDeviceSize>(std::exp2(logSize(random)));
+                VkBufferUsageFlags usage = bufferUsages[random() % 4];
+                VkMemoryPropertyFlags properties = usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                                                       ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                                       : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+                resources.emplace_back(std::make_unique<Buffer>(device, size, 1, usage, properties));
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << iterations << " operations in " << seconds << " s (" << iterations / seconds << " ops/s)\n";
+        std::cout << "after last operation:\n";
+        PrintStatistics(device.GetMemoryAllocator().GetStatistics());
+        std::cout << "device memory allocations: " << device.GetMemoryTracker().GetDeviceMemoryUsage().totalAllocations
+            << " for " << device.GetMemoryTracker().GetTotalUsage().totalAllocations << " resources" << std::endl;
+
+        resources.clear();
+    }
+}
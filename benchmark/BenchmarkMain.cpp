@@ -0,0 +1,286 @@
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "App.hpp"
+#include "Benchmarks.hpp"
+#include "CameraPath.hpp"
+#include "FrameStatistics.hpp"
+#include "Profiler.hpp"
+
+namespace
+{
+    struct BenchmarkOptions
+    {
+        uint32_t frames = 1000;
+        uint32_t warmupFrames = 30;
+        float timeStep = 1.f / 60.f;
+        bool windowed = false;
+        VulkanEngine::Model::VertexFormat vertexFormat = VulkanEngine::Model::VertexFormat::Compact;
+        bool shadows = false;
+        std::string output = "benchmark.json";
+        std::string trace;
+        // Run allocator stress test instead of rendering
+        bool allocatorStress = false;
+        // Run upload benchmark instead of rendering
+        bool upload = false;
+        // Report mesh optimizer statistics instead of rendering
+        bool meshOptimizer = false;
+        // Compare OBJ parsers instead of rendering
+        bool objParser = false;
+        // Compare vertex deduplication instead of rendering
+        bool vertexDedup = false;
+        // Report meshlet culling rate instead of rendering
+        bool meshletCulling = false;
+        bool noMeshletCulling = false;
+        std::string obj;
+        uint32_t iterations = 100000;
+    };
+
+    void PrintUsage(const char* program)
+    {
+        std::cerr << "usage: " << program
+            << " [--frames <count>] [--warmup <count>] [--timestep <seconds>] [--windowed] [--output <file>]"
+            << " [--trace <file>] [--vertex-format full|compact|compact-color]"
+            << " [--shadows] [--no-meshlet-culling]"
+            << '\n'
+            << "       " << program << " --allocator-stress [--iterations <count>]"
+            << '\n'
+            << "       " << program << " --upload [--iterations <count>]"
+            << '\n'
+            << "       " << program << " --mesh-optimizer"
+            << '\n'
+            << "       " << program << " --obj-parser [--obj <file>]"
+            << '\n'
+            << "       " << program << " --vertex-dedup [--obj <file>]"
+            << '\n'
+            << "       " << program << " --meshlet-culling [--obj <file>]"
+            << '\n';
+    }
+
+    // Whole argument must be unsigned number fitting uint32_t, std::stoul alone accepts "12abc" and wraps "-1"
+    uint32_t ParseCount(const std::string& value)
+    {
+        size_t length = 0;
+        unsigned long count = std::stoul(value, &length);
+        if (value.empty() || value[0] == '-' || length != value.size() || count > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::invalid_argument("invalid count " + value);
+        }
+        return static_cast<uint32_t>(count);
+    }
+
+    float ParseSeconds(const std::string& value)
+    {
+        size_t length = 0;
+        float seconds = std::stof(value, &length);
+        if (length != value.size())
+        {
+            throw std::invalid_argument("invalid time " + value);
+        }
+        return seconds;
+    }
+
+    bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options)
+    {
+        // Malformed numbers return false, so usage is printed instead of failing with exception
+        try
+        {
+            for (int i = 1; i < argc; i++)
+            {
+                std::string arg = argv[i];
+                bool hasValue = i + 1 < argc;
+                if (arg == "--frames" && hasValue)
+                {
+                    options.frames = ParseCount(argv[++i]);
+                }
+                else if (arg == "--warmup" && hasValue)
+                {
+                    options.warmupFrames = ParseCount(argv[++i]);
+                }
+                else if (arg == "--timestep" && hasValue)
+                {
+                    options.timeStep = ParseSeconds(argv[++i]);
+                }
+                else if (arg == "--output" && hasValue)
+                {
+                    options.output = argv[++i];
+                }
+                else if (arg == "--trace" && hasValue)
+                {
+                    options.trace = argv[++i];
+                }
+                else if (arg == "--vertex-format" && hasValue)
+                {
+                    std::string format = argv[++i];
+                    if (format == "full")
+                    {
+                        options.vertexFormat = VulkanEngine::Model::VertexFormat::Full;
+                    }
+                    else if (format == "compact")
+                    {
+                        options.vertexFormat = VulkanEngine::Model::VertexFormat::Compact;
+                    }
+                    else if (format == "compact-color")
+                    {
+                        options.vertexFormat = VulkanEngine::Model::VertexFormat::CompactColor;
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+                else if (arg == "--iterations" && hasValue)
+                {
+                    options.iterations = ParseCount(argv[++i]);
+                }
+                else if (arg == "--allocator-stress")
+                {
+                    options.allocatorStress = true;
+                }
+                else if (arg == "--upload")
+                {
+                    options.upload = true;
+                }
+                else if (arg == "--obj" && hasValue)
+                {
+                    options.obj = argv[++i];
+                }
+                else if (arg == "--vertex-dedup")
+                {
+                    options.vertexDedup = true;
+                }
+                else if (arg == "--obj-parser")
+                {
+                    options.objParser = true;
+                }
+                else if (arg == "--meshlet-culling")
+                {
+                    options.meshletCulling = true;
+                }
+                else if (arg == "--no-meshlet-culling")
+                {
+                    options.noMeshletCulling = true;
+                }
+                else if (arg == "--mesh-optimizer")
+                {
+                    options.meshOptimizer = true;
+                }
+                else if (arg == "--shadows")
+                {
+                    options.shadows = true;
+                }
+                else if (arg == "--windowed")
+                {
+                    options.windowed = true;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+        return options.frames > 0 && options.timeStep > 0.f;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options{};
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        if (options.allocatorStress)
+        {
+            VulkanEngine::RunAllocatorStress(options.iterations);
+            return EXIT_SUCCESS;
+        }
+        if (options.upload)
+        {
+            VulkanEngine::RunUploadBenchmark(options.iterations);
+            return EXIT_SUCCESS;
+        }
+        if (options.meshOptimizer)
+        {
+            VulkanEngine::RunMeshOptimizerBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if (options.objParser)
+        {
+            VulkanEngine::RunObjParserBenchmark(options.obj);
+            return EXIT_SUCCESS;
+        }
+        if (options.vertexDedup)
+        {
+            VulkanEngine::RunVertexDedupBenchmark(options.obj);
+            return EXIT_SUCCESS;
+        }
+        if (options.meshletCulling)
+        {
+            VulkanEngine::RunMeshletCullingBenchmark(options.obj);
+            return EXIT_SUCCESS;
+        }
+
+        // Camera circles around scene, one loop takes 10 seconds of simulated time.
+        VulkanEngine::AppConfig config{};
+        config.headless = !options.windowed;
+        config.frameCount = options.warmupFrames + options.frames;
+        config.fixedTimeStep = options.timeStep;
+        config.vertexFormat = options.vertexFormat;
+        config.shadows = options.shadows;
+        config.meshletCulling = !options.noMeshletCulling;
+        config.cameraPath = std::make_shared<VulkanEngine::CameraPath>(
+            VulkanEngine::CameraPath::Orbit({0.f, 0.5f, 0.f}, 2.5f, -1.f, 10.f));
+
+        VulkanEngine::FrameStatistics statistics{options.warmupFrames};
+        VulkanEngine::App app{config};
+        app.run(&statistics);
+
+        statistics.WriteJson(options.output);
+        if (!options.trace.empty())
+        {
+            VulkanEngine::Profiler::WriteChromeTrace(options.trace);
+        }
+
+        auto summary = statistics.Summarize();
+        std::cout << "frames: " << summary.frameCount
+            << ", fps: " << summary.framesPerSecond
+            << ", p50: " << summary.p50Ms << " ms"
+            << ", p95: " << summary.p95Ms << " ms"
+            << ", p99: " << summary.p99Ms << " ms"
+            << ", max: " << summary.maxMs << " ms" << std::endl;
+        for (auto& zone : summary.cpuZones)
+        {
+            std::cout << "  cpu " << zone.name << ": average " << zone.averageMs << " ms, p95 " << zone.p95Ms << " ms\n";
+        }
+        for (auto& zone : summary.gpuZones)
+        {
+            std::cout << "  gpu " << zone.name << ": average " << zone.averageMs << " ms, p95 " << zone.p95Ms << " ms\n";
+        }
+        for (auto& counters : summary.pipelineStatistics)
+        {
+            std::cout << "  " << counters.name << ": " << counters.vertexShaderInvocations << " vertex invocations, "
+                << counters.clippedRatio * 100.0 << "% primitives clipped, "
+                << counters.fragmentShaderInvocations << " fragment invocations\n";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
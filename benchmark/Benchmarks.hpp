@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Create and destroy random buffers and images on headless device and report allocator statistics.
+    /// </summary>
+    /// <param name="iterations"> Number of create or destroy operations</param>
+    void RunAllocatorStress(uint32_t iterations);
+
+    /// <summary>
+    /// Upload random sized buffers through upload context with and without staging buffer reuse and report MB/s.
+    /// </summary>
+    /// <param name="iterations"> Number of uploads in each run</param>
+    void RunUploadBenchmark(uint32_t iterations);
+
+    /// <summary>
+    /// Optimize shipped models and terrain with MeshOptimizer and report vertex cache statistics before and after.
+    /// </summary>
+    void RunMeshOptimizerBenchmark();
+
+    /// <summary>
+    /// Parse OBJ file with tinyobj and with ObjParser and report MB/s and triangles/s of both.
+    /// </summary>
+    /// <param name="filepath"> OBJ file, generated terrain is written and used if empty</param>
+    void RunObjParserBenchmark(const std::string& filepath);
+
+    /// <summary>
+    /// Deduplicate triangle corners of large mesh with std::unordered_map and VertexDeduplicator and report
+    /// lookups per second of both.
+    /// </summary>
+    /// <param name="filepath"> OBJ file, generated terrain is used if empty</param>
+    void RunVertexDedupBenchmark(const std::string& filepath);
+
+    /// <summary>
+    /// Build meshlets of models, cull them from camera orbiting each model and report share of meshlets culled
+    /// by frustum and normal cone, draws after merging and culling time per meshlet.
+    /// </summary>
+    /// <param name="filepath"> OBJ file, shipped models and terrain are used if empty</param>
+    void RunMeshletCullingBenchmark(const std::string& filepath);
+}
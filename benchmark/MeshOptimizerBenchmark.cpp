@@ -0,0 +1,41 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.hpp"
+#include "Model.hpp"
+#include "Terrain.hpp"
+
+namespace VulkanEngine
+{
+    static void Report(const std::string& name, Model::ModelData& data)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        MeshOptimizer::Report report = MeshOptimizer::Optimize(data);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << name << ": " << data.indices.size() / 3 << " triangles, " << data.vertices.size() << " vertices"
+            << ", ACMR " << report.before.acmr << " -> " << report.after.acmr
+            << ", ATVR " << report.before.atvr << " -> " << report.after.atvr
+            << ", " << ms << " ms\n";
+    }
+
+    void RunMeshOptimizerBenchmark()
+    {
+        std::cout << "FIFO cache of " << MeshOptimizer::CACHE_SIZE << " vertices\n";
+        const std::vector<std::string> models{
+            "../models/flat_vase.obj", "../models/smooth_vase.obj", "../models/quad.obj"};
+        for (const auto& path : models)
+        {
+            Model::ModelData data{};
+            data.LoadModel(path, false);
+            Report(path, data);
+        }
+
+        Model::ModelData terrain = Terrain::GenerateData(1000);
+        Report("terrain 1000x1000", terrain);
+    }
+}
@@ -0,0 +1,126 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Camera.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshletCuller.hpp"
+#include "Terrain.hpp"
+
+namespace VulkanEngine
+{
+    // Camera positions on orbit around model, every other one looks past model so frustum culls part of it
+    static constexpr uint32_t VIEWS = 64;
+    // Culling of each view is repeated to get measurable time
+    static constexpr uint32_t REPEATS = 100;
+
+    static void Report(const std::string& name, const Model::ModelData& data)
+    {
+        if (data.vertices.size() > Model::MAX_CHUNK_VERTICES)
+        {
+            std::cout << name << ": more than " << Model::MAX_CHUNK_VERTICES << " vertices, skipped\n";
+            return;
+        }
+
+        // Whole mesh is single chunk, like Model uses it
+        std::vector<uint16_t> indices(data.indices.begin(), data.indices.end());
+        Model::Chunk chunk{0, static_cast<uint32_t>(indices.size()), 0};
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<Model::Meshlet> meshlets = MeshletCuller::Build(data.vertices, indices, chunk);
+        double buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        auto meshletCount = static_cast<uint32_t>(meshlets.size());
+
+        BoundingBox bounds{};
+        for (const auto& vertex : data.vertices)
+        {
+            bounds.Extend(vertex.position);
+        }
+        glm::vec3 center = bounds.GetCenter();
+        float radius = glm::length(bounds.GetExtent()) * 0.5f;
+        Camera camera{};
+        camera.SetPerspectiveProjection(glm::radians(50.f), 4.f / 3.f, radius * 0.01f, radius * 100.f);
+
+        uint64_t frustumCulled = 0;
+        uint64_t coneCulled = 0;
+        uint64_t visible = 0;
+        uint64_t draws = 0;
+        double cullSeconds = 0.0;
+        std::vector<VkDrawIndexedIndirectCommand> commands;
+        for (uint32_t i = 0; i < VIEWS; i++)
+        {
+            float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(VIEWS);
+            glm::vec3 offset{std::cos(angle), 0.5f * std::sin(angle * 3.f), std::sin(angle)};
+            glm::vec3 position = center + offset * radius * 2.f;
+            glm::vec3 target = center;
+            if (i % 2 == 1)
+            {
+                target += glm::cross(offset, glm::vec3{0.f, 1.f, 0.f}) * radius;
+            }
+            camera.SetViewTarget(position, target);
+            Frustum frustum = Frustum::FromMatrix(camera.GetProjectionMatrix() * camera.GetViewMatrix());
+
+            for (const auto& meshlet : meshlets)
+            {
+                if (MeshletCuller::IsOutsideFrustum(meshlet, frustum))
+                {
+                    frustumCulled++;
+                }
+                else if (MeshletCuller::IsBackFacing(meshlet, position))
+                {
+                    coneCulled++;
+                }
+            }
+
+            start = std::chrono::high_resolution_clock::now();
+            for (uint32_t repeat = 0; repeat < REPEATS; repeat++)
+            {
+                commands.clear();
+                MeshletCuller::Cull(meshlets.data(), meshletCount, frustum, position, 0, 0, commands);
+            }
+            cullSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            commands.clear();
+            visible += MeshletCuller::Cull(meshlets.data(), meshletCount, frustum, position, 0, 0, commands);
+            draws += commands.size();
+        }
+
+        double total = static_cast<double>(meshletCount) * VIEWS;
+        std::cout << name << ": " << data.indices.size() / 3 << " triangles, " << meshletCount << " meshlets, "
+            << static_cast<double>(data.indices.size()) / 3.0 / meshletCount << " triangles per meshlet, built in "
+            << buildMs << " ms\n"
+            << "  visible " << 100.0 * visible / total << "%, frustum culled " << 100.0 * frustumCulled / total
+            << "%, cone culled " << 100.0 * coneCulled / total << "%, "
+            << static_cast<double>(draws) / VIEWS << " draws per view, "
+            << cullSeconds * 1e9 / (total * REPEATS) << " ns per meshlet\n";
+    }
+
+    void RunMeshletCullingBenchmark(const std::string& filepath)
+    {
+        std::cout << "Meshlets of at most " << Model::MAX_MESHLET_VERTICES << " vertices and "
+            << Model::MAX_MESHLET_TRIANGLES << " triangles, " << VIEWS << " views\n";
+        if (!filepath.empty())
+        {
+            Model::ModelData data{};
+            data.LoadModel(filepath);
+            Report(filepath, data);
+            return;
+        }
+
+        for (const char* path : {"../models/flat_vase.obj", "../models/smooth_vase.obj"})
+        {
+            Model::ModelData data{};
+            data.LoadModel(path);
+            Report(path, data);
+        }
+        // Largest terrain fitting single chunk
+        Model::ModelData terrain = Terrain::GenerateData(256);
+        MeshOptimizer::Optimize(terrain);
+        Report("terrain 256x256", terrain);
+    }
+}
@@ -0,0 +1,92 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include "ObjParser.hpp"
+#include "Terrain.hpp"
+
+namespace VulkanEngine
+{
+    static constexpr int TERRAIN_POINTS = 1000;
+    static constexpr double MB = 1024.0 * 1024.0;
+
+    // Write terrain as OBJ with positions, normals and texture coordinates, about 2M triangles.
+    static void WriteTerrainObj(const std::string& filepath)
+    {
+        Model::ModelData data = Terrain::GenerateData(TERRAIN_POINTS);
+        std::ofstream file{filepath};
+        if (!file)
+        {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+        for (const auto& vertex : data.vertices)
+        {
+            file << "v " << vertex.position.x << ' ' << vertex.position.y << ' ' << vertex.position.z << '\n';
+            file << "vn " << vertex.normal.x << ' ' << vertex.normal.y << ' ' << vertex.normal.z << '\n';
+            file << "vt " << vertex.texCord.x << ' ' << vertex.texCord.y << '\n';
+        }
+        for (size_t i = 0; i < data.indices.size(); i += 3)
+        {
+            file << 'f';
+            for (size_t j = i; j < i + 3; j++)
+            {
+                uint32_t index = data.indices[j] + 1;
+                file << ' ' << index << '/' << index << '/' << index;
+            }
+            file << '\n';
+        }
+    }
+
+    static void Report(const char* name, double seconds, size_t fileSize, size_t triangles)
+    {
+        std::cout << name << ": " << seconds * 1000.0 << " ms, " << fileSize / MB / seconds << " MB/s, "
+            << triangles / seconds / 1e6 << " M triangles/s\n";
+    }
+
+    void RunObjParserBenchmark(const std::string& filepath)
+    {
+        std::string path = filepath;
+        if (path.empty())
+        {
+            path = "obj_parser_benchmark.obj";
+            std::cout << "writing " << TERRAIN_POINTS << "x" << TERRAIN_POINTS << " terrain to " << path << '\n';
+            WriteTerrainObj(path);
+        }
+
+        // First parse also brings file into page cache, so both parsers read it from memory
+        ObjParser::Mesh mesh = ObjParser::Parse(path);
+        size_t fileSize = static_cast<size_t>(std::ifstream{path, std::ios::binary | std::ios::ate}.tellg());
+        size_t triangles = mesh.indices.size() / 3;
+        std::cout << path << ": " << fileSize / MB << " MB, " << triangles << " triangles\n";
+
+        auto start = std::chrono::high_resolution_clock::now();
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+        Report("tinyobj", std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(),
+               fileSize, triangles);
+
+        start = std::chrono::high_resolution_clock::now();
+        mesh = ObjParser::Parse(path, 1);
+        Report("ObjParser, 1 thread", std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(),
+               fileSize, triangles);
+
+        start = std::chrono::high_resolution_clock::now();
+        mesh = ObjParser::Parse(path);
+        Report("ObjParser, all threads",
+               std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(),
+               fileSize, triangles);
+    }
+}
@@ -0,0 +1,79 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "UploadContext.hpp"
+
+namespace VulkanEngine
+{
+    // Uploads recorded before each submit, like assets loaded in one frame
+    static constexpr uint32_t UPLOADS_PER_BATCH = 16;
+    // Batches in flight before oldest is waited for
+    static constexpr uint32_t BATCHES_IN_FLIGHT = 2;
+    static constexpr uint32_t DESTINATION_COUNT = 64;
+    static constexpr VkDeviceSize MAX_UPLOAD_SIZE = 4ull * 1024 * 1024;
+
+    static void RunUploads(Device& device, const char* name, VkDeviceSize stagingCacheSize, uint32_t iterations,
+                           const std::vector<std::unique_ptr<Buffer>>& destinations, const std::vector<char>& source)
+    {
+        UploadContext uploadContext{device, stagingCacheSize};
+
+        // Same seed in both runs, so they upload same sizes
+        std::mt19937 random{42};
+        std::uniform_real_distribution<double> logSize{10.0, std::log2(static_cast<double>(MAX_UPLOAD_SIZE))};
+
+        VkDeviceSize uploadedBytes = 0;
+        std::vector<UploadToken> tokens;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            auto size = static_cast<VkDeviceSize>(std::exp2(logSize(random)));
+            uploadContext.UploadBuffer(source.data(), size, destinations[i % DESTINATION_COUNT]->GetBuffer());
+            uploadedBytes += size;
+
+            if ((i + 1) % UPLOADS_PER_BATCH == 0)
+            {
+                tokens.push_back(uploadContext.Submit());
+                if (tokens.size() > BATCHES_IN_FLIGHT)
+                {
+                    uploadContext.Wait(tokens[tokens.size() - 1 - BATCHES_IN_FLIGHT]);
+                }
+            }
+        }
+        uploadContext.WaitAll();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        auto staging = uploadContext.GetStagingStatistics();
+        constexpr double MB = 1024.0 * 1024.0;
+        std::cout << name << ": " << uploadedBytes / MB << " MB in " << seconds << " s ("
+            << uploadedBytes / MB / seconds << " MB/s), staging buffers created: " << staging.created << " of "
+            << staging.acquired << std::endl;
+    }
+
+    void RunUploadBenchmark(uint32_t iterations)
+    {
+        Device device{};
+        std::cout << "transfer queue: " << (device.HasDedicatedTransferQueue() ? "dedicated" : "graphics") << '\n';
+
+        std::vector<std::unique_ptr<Buffer>> destinations;
+        for (uint32_t i = 0; i < DESTINATION_COUNT; i++)
+        {
+            destinations.push_back(std::make_unique<Buffer>(
+                device, MAX_UPLOAD_SIZE, 1,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        }
+        std::vector<char> source(MAX_UPLOAD_SIZE, 1);
+
+        // Without cache staging buffers are created for each batch and destroyed when it finishes.
+        RunUploads(device, "unpooled staging", 0, iterations, destinations, source);
+        RunUploads(device, "pooled staging", StagingPool::DEFAULT_CACHE_SIZE, iterations, destinations, source);
+    }
+}
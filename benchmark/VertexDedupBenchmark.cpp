@@ -0,0 +1,100 @@
+#include "Benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "ObjParser.hpp"
+#include "Terrain.hpp"
+#include "Utils.hpp"
+#include "VertexDeduplicator.hpp"
+
+namespace VulkanEngine
+{
+    // Hash of previous implementation, with seed initialized
+    struct CombinedVertexHash
+    {
+        size_t operator()(const Model::Vertex& vertex) const
+        {
+            size_t seed = 0;
+            HashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.texCord);
+            return seed;
+        }
+    };
+
+    // Vertex of every triangle corner, like LoadModel sees them before deduplication
+    static std::vector<Model::Vertex> LoadCorners(const std::string& filepath)
+    {
+        std::vector<Model::Vertex> corners;
+        if (filepath.empty())
+        {
+            Model::ModelData terrain = Terrain::GenerateData(1000);
+            corners.reserve(terrain.indices.size());
+            for (uint32_t index : terrain.indices)
+            {
+                corners.push_back(terrain.vertices[index]);
+            }
+            return corners;
+        }
+
+        ObjParser::Mesh mesh = ObjParser::Parse(filepath);
+        corners.reserve(mesh.indices.size());
+        for (const auto& index : mesh.indices)
+        {
+            Model::Vertex vertex{};
+            vertex.position = mesh.positions[index.position];
+            vertex.color = mesh.colors[index.position];
+            vertex.normal = index.normal >= 0 ? mesh.normals[index.normal] : glm::vec3{0.f};
+            vertex.texCord = index.texCord >= 0 ? mesh.texCords[index.texCord] : glm::vec2{0.f};
+            corners.push_back(vertex);
+        }
+        return corners;
+    }
+
+    static void Report(const char* name, double seconds, size_t corners, size_t vertices)
+    {
+        std::cout << name << ": " << seconds * 1000.0 << " ms, " << corners / seconds / 1e6 << " M lookups/s, "
+            << vertices << " unique vertices\n";
+    }
+
+    void RunVertexDedupBenchmark(const std::string& filepath)
+    {
+        std::vector<Model::Vertex> corners = LoadCorners(filepath);
+        std::cout << (filepath.empty() ? "terrain 1000x1000" : filepath) << ": " << corners.size() << " corners\n";
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<Model::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        indices.reserve(corners.size());
+        std::unordered_map<Model::Vertex, uint32_t, CombinedVertexHash> map;
+        for (const auto& corner : corners)
+        {
+            if (map.count(corner) == 0)
+            {
+                map[corner] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(corner);
+            }
+            indices.push_back(map[corner]);
+        }
+        Report("unordered_map", std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(),
+               corners.size(), vertices.size());
+
+        // Capacity is reserved from corner count / 6, like LoadModel reserves it from position count
+        start = std::chrono::high_resolution_clock::now();
+        vertices.clear();
+        indices.clear();
+        VertexDeduplicator deduplicator{corners.size() / 6};
+        for (const auto& corner : corners)
+        {
+            indices.push_back(deduplicator.Insert(corner, vertices));
+        }
+        Report("VertexDeduplicator",
+               std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(),
+               corners.size(), vertices.size());
+    }
+}
@@ -2,14 +2,18 @@
 #include "App.hpp"
 #include "RenderSystems/ObjectRenderSystem.hpp"
 #include "RenderSystems/PointLightSystem.hpp"
+#include "RenderSystems/OffscreenShadowRenderSystem.hpp"
 #include <array>
 #include <chrono>
 #include <iostream>
 #include <ostream>
 #include <stdexcept>
 #include "Buffer.hpp"
+#include "FrameRingBuffer.hpp"
 #include "Image.hpp"
 #include "Terrain.hpp"
+#include "Profiler.hpp"
+#include "UploadContext.hpp"
 
 namespace VulkanEngine
 {
@@ -23,13 +27,32 @@ namespace VulkanEngine
         glm::vec4 lightColor{ 1.f };
     };
 
-    App::App()
+    App::App(const AppConfig& config):
+        config(config)
     {
+        if (config.headless)
+        {
+            if (config.frameCount == 0)
+            {
+                throw std::invalid_argument("headless run requires frame count");
+            }
+            device = std::make_unique<Device>();
+            renderer = std::make_unique<Renderer>(*device, VkExtent2D{WIDTH, HEIGHT});
+        }
+        else
+        {
+            window = std::make_unique<Window>(WIDTH, HEIGHT, "VULKAN");
+            device = std::make_unique<Device>(*window);
+            renderer = std::make_unique<Renderer>(*window, *device);
+        }
+        residency = std::make_unique<ResidencyManager>(*device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+        assets = std::make_unique<AssetRegistry>(*device, *residency);
+
         LoadGameObjects();
 
-        globalPool = DescriptorPool::Builder(device)
-            .SetMaxSets(static_cast<uint32_t>(gameObjects.size()) + SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+        globalPool = DescriptorPool::Builder(*device)
+            .SetMaxSets(static_cast<uint32_t>(gameObjects.size()) + 1)
+            .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
             .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(gameObjects.size()))
             .Build();
     }
@@ -38,44 +61,51 @@ namespace VulkanEngine
     {
     }
 
-    void App::run()
+    bool App::ShouldStop(uint32_t renderedFrames)
     {
-        std::vector<std::unique_ptr<Buffer>> uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < uboBuffers.size(); i++) {
-            uboBuffers[i] = std::make_unique<Buffer>(
-                device,
-                sizeof(GlobalUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-            uboBuffers[i]->Map();
+        if (config.frameCount > 0 && renderedFrames >= config.frameCount)
+        {
+            return true;
         }
+        return window != nullptr && window->ShouldClose();
+    }
+
+    void App::run(FrameStatistics* statistics)
+    {
+        // Global UBO and any other transient data of frame are pushed here
+        FrameRingBuffer frameData{*device, FRAME_DATA_SIZE, SwapChain::MAX_FRAMES_IN_FLIGHT, sizeof(GlobalUbo)};
 
-        auto globalSetLayout = DescriptorSetLayout::Builder(device)
-            .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        auto globalSetLayout = DescriptorSetLayout::Builder(*device)
+            .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
             .Build();
 
-        std::shared_ptr modelSetLayout = DescriptorSetLayout::Builder(device)
+        std::shared_ptr modelSetLayout = DescriptorSetLayout::Builder(*device)
             .AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .Build();
 
-        std::vector<VkDescriptorSet> globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
-        for(int i = 0; i< globalDescriptorSets.size();i++)
-        {
-            auto bufferInfo = uboBuffers[i]->DescriptorInfo();
-
-            DescriptorWriter(*globalSetLayout, *globalPool)
-                .WriteBuffer(0, &bufferInfo)
-                .Build(globalDescriptorSets[i]);
-        }
+        // Single set serves all frames, dynamic offset selects data
+        VkDescriptorSet globalDescriptorSet;
+        auto frameDataInfo = frameData.DescriptorInfo();
+        DescriptorWriter(*globalSetLayout, *globalPool)
+            .WriteBuffer(0, &frameDataInfo)
+            .Build(globalDescriptorSet);
 
         for (auto& object : gameObjects)
         {
             if(object.second.texture != nullptr)
             {
-                DescriptorWriter(*modelSetLayout, *globalPool)
-                   .WriteImage(0, &object.second.texture->GetDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
-                   .Build(object.second.descriptorSet);
+                // Texture which didn't fit into memory is written by render system once it is restored
+                if (object.second.texture->IsResident())
+                {
+                    DescriptorWriter(*modelSetLayout, *globalPool)
+                       .WriteImage(0, &object.second.texture->GetDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+                       .Build(object.second.descriptorSet);
+                    object.second.textureGeneration = object.second.texture->GetGeneration();
+                }
+                else if (!globalPool->AllocateDescriptor(modelSetLayout->GetDescriptorSetLayout(), object.second.descriptorSet))
+                {
+                    throw std::runtime_error("failed to allocate descriptor set!");
+                }
             }
         }
 
@@ -85,65 +115,176 @@ namespace VulkanEngine
 
         // Ad object render system
         renderSystems.push_back(std::make_unique<ObjectRenderSystem>(
-            device, renderer.getSwapChainRenderPass(), std::vector{ globalSetLayout->GetDescriptorSetLayout(), modelSetLayout->GetDescriptorSetLayout() }));
+            *device, renderer->getSwapChainRenderPass(), std::vector{ globalSetLayout->GetDescriptorSetLayout(), modelSetLayout->GetDescriptorSetLayout() },
+            config.meshletCulling));
 
         // Add point light render system
         renderSystems.push_back(std::make_unique<PointLightSystem>(
-            device, renderer.getSwapChainRenderPass(),globalSetLayout->GetDescriptorSetLayout() ));
+            *device, renderer->getSwapChainRenderPass(),globalSetLayout->GetDescriptorSetLayout() ));
+
+        // Systems rendering into own targets, recorded before swap chain render pass
+        std::vector<std::unique_ptr<RenderSystem>> offscreenRenderSystems;
+        if (config.shadows)
+        {
+            auto shadowSystem = std::make_unique<OffscreenShadowRenderSystem>(*device);
+            // Light doesn't move
+            shadowSystem->SetLight(glm::vec3{GlobalUbo{}.lightPosition}, {0.f, 0.5f, 0.f});
+            offscreenRenderSystems.push_back(std::move(shadowSystem));
+        }
 
         auto cameraObject = GameObject::CreateGameObject();
         cameraObject.transform.translation.z = -2.5f;
         KeyboardController cameraController{};
 
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        while (!window.ShouldClose())
+        GpuProfiler& gpuProfiler = renderer->GetGpuProfiler();
+
+        uint32_t renderedFrames = 0;
+        float simulationTime = 0.f;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto currentTime = startTime;
+        while (!ShouldStop(renderedFrames))
         {
+            PROFILE_SCOPE("Frame");
+
             // Calculate time between frames
-            glfwPollEvents();
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            cameraController.MoveInPlane(window, frameTime, cameraObject);
+            // Fixed time step makes runs independent of real frame times.
+            if (config.fixedTimeStep > 0.f)
+            {
+                frameTime = config.fixedTimeStep;
+            }
+            simulationTime += frameTime;
+
+            if (window != nullptr)
+            {
+                glfwPollEvents();
+            }
+
+            // There is no user input without window, so camera stays in place unless path is given.
+            if (config.cameraPath != nullptr)
+            {
+                config.cameraPath->Apply(simulationTime, cameraObject);
+            }
+            else if (window != nullptr)
+            {
+                cameraController.MoveInPlane(*window, frameTime, cameraObject);
+            }
             camera.SetViewYXZ(cameraObject.transform.translation, cameraObject.transform.rotation);
 
-            float aspect = renderer.GetAspectRatio();
+            float aspect = renderer->GetAspectRatio();
             camera.SetPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10);
 
-            if (auto commandBuffer = renderer.BeginFrame())
+            if (auto commandBuffer = renderer->BeginFrame())
             {
-                int frameIndex = renderer.GetFrameIndex();
-                FrameInfo frameInfo{ frameIndex, frameTime, camera, commandBuffer, globalDescriptorSets[frameIndex], gameObjects};
+                int frameIndex = renderer->GetFrameIndex();
+                residency->BeginFrame();
 
+                PROFILE_SCOPE("App::RecordFrame");
+                frameData.BeginFrame(frameIndex);
                 GlobalUbo ubo{};
 
                 ubo.projectionMatrix = camera.GetProjectionMatrix();
                 ubo.viewMatrix = camera.GetViewMatrix();
-                uboBuffers[frameIndex]->WriteToBuffer(&ubo);
+                uint32_t globalUboOffset = frameData.Push(ubo);
 
-                renderer.BeginSwapChainRenderPass(commandBuffer);
+                FrameInfo frameInfo{ frameIndex, frameTime, camera, renderer->GetExtent(), commandBuffer, globalDescriptorSet,
+                                     globalUboOffset, frameData, gameObjects, *residency};
+
+                // Each render system will render this frame, measured on both CPU and GPU
+                std::vector<FrameStatistics::ZoneSample> cpuZones;
+                auto renderMeasured = [&](RenderSystem& renderSystem)
+                {
+                    auto zoneStart = std::chrono::high_resolution_clock::now();
+                    uint32_t gpuZone = gpuProfiler.BeginZone(commandBuffer, renderSystem.GetName());
+                    uint32_t statisticsQuery = gpuProfiler.BeginStatistics(commandBuffer, renderSystem.GetName());
+                    renderSystem.Render(frameInfo);
+                    gpuProfiler.EndStatistics(commandBuffer, statisticsQuery);
+                    gpuProfiler.EndZone(commandBuffer, gpuZone);
+                    cpuZones.push_back({renderSystem.GetName(), std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - zoneStart).count()});
+                };
+
+                for (auto& renderSystem : offscreenRenderSystems)
+                {
+                    renderMeasured(*renderSystem);
+                }
 
-                // Each render system will render this frame
+                renderer->BeginSwapChainRenderPass(commandBuffer);
                 for (auto &renderSystem : renderSystems)
                 {
-                    renderSystem->Render(frameInfo);
+                    renderMeasured(*renderSystem);
                 }
+                renderer->EndSwapChainRenderPass(commandBuffer);
+                renderer->EndFrame();
+                renderedFrames++;
 
-                renderer.EndSwapChainRenderPass(commandBuffer);
-                renderer.EndFrame();
+                if (statistics != nullptr)
+                {
+                    statistics->AddFrame(std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - newTime).count(), std::move(cpuZones));
+                }
+                AddGpuTimes(statistics);
             }
         }
 
-        vkDeviceWaitIdle(device.GetDevice());
+        vkDeviceWaitIdle(device->GetDevice());
+
+        gpuProfiler.CollectPending();
+        AddGpuTimes(statistics);
+
+        if (config.headless)
+        {
+            float totalTime = std::chrono::duration<float, std::chrono::seconds::period>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+            std::cout << "Rendered " << renderedFrames << " frames in " << totalTime << " s ("
+                << renderedFrames / totalTime << " fps)" << std::endl;
+        }
+    }
+
+    void App::AddGpuTimes(FrameStatistics* statistics)
+    {
+        // Results are taken even without statistics, so they don't pile up in profiler.
+        auto results = renderer->GetGpuProfiler().TakeResults();
+        if (statistics == nullptr)
+        {
+            return;
+        }
+
+        for (auto& result : results)
+        {
+            std::vector<FrameStatistics::ZoneSample> gpuZones;
+            gpuZones.reserve(result.zones.size());
+            for (auto& zone : result.zones)
+            {
+                gpuZones.push_back({zone.name, zone.timeMs});
+            }
+            statistics->AddGpuTimes(result.frameNumber, std::move(gpuZones));
+
+            std::vector<FrameStatistics::PipelineStatisticsSample> pipelineStatistics;
+            pipelineStatistics.reserve(result.statistics.size());
+            for (auto& counters : result.statistics)
+            {
+                pipelineStatistics.push_back({counters.name, counters.vertexShaderInvocations,
+                    counters.clippingInvocations, counters.clippingPrimitives, counters.fragmentShaderInvocations});
+            }
+            statistics->AddPipelineStatistics(result.frameNumber, std::move(pipelineStatistics));
+        }
     }
 
     void App::LoadGameObjects()
     {
-        std::shared_ptr flatModel = Model::CreateModelFromFile(device, "../models/flat_vase.obj");
-        std::shared_ptr smoothModel = Model::CreateModelFromFile(device, "../models/smooth_vase.obj");
-        std::shared_ptr floorModel = Model::CreateModelFromFile(device, "../models/quad.obj");
-        std::shared_ptr vaseTexture = Image::LoadImageFromFile("../textures/vase_texture.jpg", device);
-        std::shared_ptr floorTexture = Image::LoadImageFromFile("../textures/floor_texture.jfif", device);
+        PROFILE_SCOPE("App::LoadGameObjects");
+        // Depth only shadow pass fetches positions alone
+        auto vertexStreams = config.shadows ? Model::VertexStreams::SplitPositions : Model::VertexStreams::Interleaved;
+        // Registry loads each file once and registers it in residency manager
+        auto flatModel = assets->LoadModel("../models/flat_vase.obj", config.vertexFormat, vertexStreams);
+        auto smoothModel = assets->LoadModel("../models/smooth_vase.obj", config.vertexFormat, vertexStreams);
+        auto floorModel = assets->LoadModel("../models/quad.obj", config.vertexFormat, vertexStreams);
+        auto vaseTexture = assets->LoadTexture("../textures/vase_texture.jpg");
+        auto floorTexture = assets->LoadTexture("../textures/floor_texture.jfif");
 
         auto flatVase = GameObject::CreateGameObject();
         flatVase.model = flatModel;
@@ -166,6 +307,9 @@ namespace VulkanEngine
         floor.texture = floorTexture;
         gameObjects.emplace(floor.GetId(), std::move(floor));
 
+        // All models and textures are uploaded by single submit
+        device->GetUploadContext().WaitAll();
+
 
         // auto terrain = GameObject::CreateGameObject();
         // terrain.model = Terrain::Generate(device, 1000);
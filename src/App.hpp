@@ -12,9 +12,40 @@
 #include "Camera.hpp"
 #include "KeyboardController.hpp"
 #include "Descriptors.hpp"
+#include "CameraPath.hpp"
+#include "FrameStatistics.hpp"
+#include "ResidencyManager.hpp"
+#include "AssetRegistry.hpp"
 
 namespace VulkanEngine
 {
+    /// <summary>
+    /// Options how application should be run.
+    /// </summary>
+    struct AppConfig
+    {
+        // Render into offscreen attachments, without window and swap chain.
+        bool headless = false;
+
+        // Number of frames to render, 0 means until window is closed.
+        uint32_t frameCount = 0;
+
+        // Simulated time between frames in seconds, 0 means real time is used.
+        float fixedTimeStep = 0.f;
+
+        // Scripted camera movement used instead of user input.
+        std::shared_ptr<const CameraPath> cameraPath;
+
+        // Vertex layout of loaded models, scene is textured, so vertex colors are not needed.
+        Model::VertexFormat vertexFormat = Model::VertexFormat::Compact;
+
+        // Render shadow map each frame, models then store positions in separate stream for it.
+        bool shadows = false;
+
+        // Cull meshlets of models on CPU and draw only visible ones.
+        bool meshletCulling = true;
+    };
+
     /// <summary>
     /// Main class of application, which is supposed to combine everything.
     /// </summary>
@@ -23,26 +54,48 @@ namespace VulkanEngine
     public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        // Transient uniform data available to each frame
+        static constexpr VkDeviceSize FRAME_DATA_SIZE = 256 * 1024;
 
         /// <summary>
         /// App constructor will do vulkan, glfw and objects setup
         /// </summary>
-        App();
+        /// <param name="config"> How application should be run</param>
+        App(const AppConfig& config = {});
         ~App();
 
         /// <summary>
         /// Main appliaction function. It will render frames
-        /// until close command will be sent to window
+        /// until close command will be sent to window or frame count is reached
         /// </summary>
-        void run();
+        /// <param name="statistics"> Optional statistics to record frame timings into</param>
+        void run(FrameStatistics* statistics = nullptr);
 
         App(const App&) = delete;
         App& operator=(const App&) = delete;
 
     private:
-        Window window{WIDTH, HEIGHT, "VULKAN"};
-        Device device{window};
-        Renderer renderer{window, device};
+        /// <summary>
+        /// Check if render loop should finish.
+        /// </summary>
+        /// <param name="renderedFrames"> Number of frames rendered so far</param>
+        /// <returns> true if no more frames should be rendered</returns>
+        bool ShouldStop(uint32_t renderedFrames);
+
+        /// <summary>
+        /// Move GPU times and pipeline statistics of finished frames from profiler to statistics.
+        /// </summary>
+        /// <param name="statistics"> Statistics to attach times to, results are dropped if null</param>
+        void AddGpuTimes(FrameStatistics* statistics);
+
+        AppConfig config;
+
+        // Window is not created in headless mode.
+        std::unique_ptr<Window> window;
+        std::unique_ptr<Device> device;
+        std::unique_ptr<Renderer> renderer;
+        std::unique_ptr<ResidencyManager> residency;
+        std::unique_ptr<AssetRegistry> assets;
 
         std::shared_ptr<DescriptorPool> globalPool{};
         GameObject::Map gameObjects;
@@ -0,0 +1,190 @@
+#include "AssetRegistry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    AssetRegistry::AssetRegistry(Device& device, ResidencyManager& residency):
+        device(device),
+        residency(residency)
+    {
+    }
+
+    std::string AssetRegistry::NormalizePath(const std::string& filepath)
+    {
+        std::error_code error;
+        std::filesystem::path normalized = std::filesystem::weakly_canonical(filepath, error);
+        if (error)
+        {
+            normalized = std::filesystem::absolute(filepath, error).lexically_normal();
+        }
+        return normalized.generic_string();
+    }
+
+    uint64_t AssetRegistry::HashContent(const MappedFile& file)
+    {
+        PROFILE_SCOPE("AssetRegistry::HashContent");
+        const char* data = file.GetData();
+        size_t size = file.GetSize();
+
+        // Multiply-xorshift over 8 byte words, tail is zero padded, size is mixed in so padding can't collide
+        uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+        for (size_t offset = 0; offset < size; offset += sizeof(uint64_t))
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, data + offset, std::min(sizeof(uint64_t), size - offset));
+            hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+            hash ^= hash >> 32;
+        }
+        // splitmix64 finalizer
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    bool AssetRegistry::HasSameContent(const std::string& filepath, const MappedFile& file)
+    {
+        PROFILE_SCOPE("AssetRegistry::HasSameContent");
+        try
+        {
+            MappedFile other{filepath};
+            return other.GetSize() == file.GetSize() &&
+                (file.GetSize() == 0 || std::memcmp(other.GetData(), file.GetData(), file.GetSize()) == 0);
+        }
+        catch (const std::runtime_error&)
+        {
+            // Source of loaded asset was removed
+            return false;
+        }
+    }
+
+    template <typename T, typename Load>
+    std::shared_ptr<T> AssetRegistry::FindOrLoad(AssetType type, const std::string& variant,
+                                                 const std::string& filepath, Load load)
+    {
+        std::string pathKey = variant + '|' + NormalizePath(filepath);
+        auto path = paths.find(pathKey);
+        if (path != paths.end())
+        {
+            statistics.pathHits++;
+            return std::static_pointer_cast<T>(assets.at(path->second).resource);
+        }
+
+        // New path may still be copy of loaded file, hash only finds candidate which is compared byte by byte
+        uint64_t contentHash;
+        std::string contentKey;
+        {
+            MappedFile file{filepath};
+            contentHash = HashContent(file);
+            std::string hashKey = variant + '|' + std::to_string(file.GetSize()) + '|' + std::to_string(contentHash);
+            for (uint32_t collision = 0;; collision++)
+            {
+                contentKey = collision == 0 ? hashKey : hashKey + '#' + std::to_string(collision);
+                auto asset = assets.find(contentKey);
+                if (asset == assets.end())
+                {
+                    break;
+                }
+                if (HasSameContent(asset->second.path, file))
+                {
+                    statistics.contentHits++;
+                    paths.emplace(pathKey, contentKey);
+                    return std::static_pointer_cast<T>(asset->second.resource);
+                }
+            }
+        }
+
+        std::shared_ptr<T> resource = load();
+        residency.Register(resource);
+        assets.emplace(contentKey, Asset{type, filepath, contentHash, resource});
+        paths.emplace(pathKey, contentKey);
+        statistics.loads++;
+        return resource;
+    }
+
+    std::shared_ptr<Model> AssetRegistry::LoadModel(const std::string& filepath, Model::VertexFormat vertexFormat,
+                                                    Model::VertexStreams vertexStreams)
+    {
+        PROFILE_SCOPE("AssetRegistry::LoadModel");
+        // Each vertex layout is separate geometry on device
+        std::string variant = "model:" + std::to_string(static_cast<uint32_t>(vertexFormat)) + ':' +
+            std::to_string(static_cast<uint32_t>(vertexStreams));
+        return FindOrLoad<Model>(AssetType::Model, variant, filepath, [&]()
+        {
+            return std::shared_ptr<Model>{Model::CreateModelFromFile(device, filepath, vertexFormat, vertexStreams)};
+        });
+    }
+
+    std::shared_ptr<Image> AssetRegistry::LoadTexture(const std::string& filepath)
+    {
+        PROFILE_SCOPE("AssetRegistry::LoadTexture");
+        return FindOrLoad<Image>(AssetType::Image, "image", filepath, [&]()
+        {
+            return std::shared_ptr<Image>{Image::LoadImageFromFile(filepath, device)};
+        });
+    }
+
+    void AssetRegistry::Remove(const std::string& contentKey)
+    {
+        for (auto path = paths.begin(); path != paths.end();)
+        {
+            path = path->second == contentKey ? paths.erase(path) : std::next(path);
+        }
+        assets.erase(contentKey);
+        statistics.unloads++;
+    }
+
+    uint32_t AssetRegistry::Unload(const std::string& filepath)
+    {
+        // Path may lead to asset in several variants
+        std::string normalized = '|' + NormalizePath(filepath);
+        std::vector<std::string> contentKeys;
+        for (const auto& path : paths)
+        {
+            if (path.first.size() > normalized.size() &&
+                path.first.compare(path.first.size() - normalized.size(), normalized.size(), normalized) == 0)
+            {
+                contentKeys.push_back(path.second);
+            }
+        }
+        for (const auto& contentKey : contentKeys)
+        {
+            Remove(contentKey);
+        }
+        return static_cast<uint32_t>(contentKeys.size());
+    }
+
+    uint32_t AssetRegistry::UnloadUnused()
+    {
+        std::vector<std::string> contentKeys;
+        for (const auto& asset : assets)
+        {
+            if (asset.second.resource.use_count() == 1)
+            {
+                contentKeys.push_back(asset.first);
+            }
+        }
+        for (const auto& contentKey : contentKeys)
+        {
+            Remove(contentKey);
+        }
+        return static_cast<uint32_t>(contentKeys.size());
+    }
+
+    std::vector<AssetRegistry::AssetInfo> AssetRegistry::GetAssets() const
+    {
+        std::vector<AssetInfo> infos;
+        infos.reserve(assets.size());
+        for (const auto& asset : assets)
+        {
+            const Asset& entry = asset.second;
+            infos.push_back({entry.type, entry.path, entry.contentHash, entry.resource.use_count() - 1,
+                             entry.resource->IsResident(), entry.resource->GetMemorySize()});
+        }
+        return infos;
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Device.hpp"
+#include "Image.hpp"
+#include "MappedFile.hpp"
+#include "Model.hpp"
+#include "ResidencyManager.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Loads models and textures from files at most once and hands out shared handles to them. Assets are
+    /// found by normalized path first and by size and hash of file content when path is new, bytes are compared
+    /// before asset is reused, so copies of same file under different names share device memory too. Registry keeps every asset alive until it is unloaded
+    /// and registers it in ResidencyManager.
+    /// </summary>
+    class AssetRegistry
+    {
+    public:
+        enum class AssetType : uint32_t
+        {
+            Model,
+            Image
+        };
+
+        /// <summary>
+        /// State of one loaded asset.
+        /// </summary>
+        struct AssetInfo
+        {
+            AssetType type;
+            // Path asset was loaded from, other paths with same content share it
+            std::string path;
+            uint64_t contentHash;
+            // Handles held outside of registry
+            long useCount;
+            bool resident;
+            VkDeviceSize memorySize;
+        };
+
+        struct Statistics
+        {
+            // Assets loaded from files
+            uint64_t loads = 0;
+            // Requests served by known path
+            uint64_t pathHits = 0;
+            // Requests of new path served by asset with same content
+            uint64_t contentHits = 0;
+            uint64_t unloads = 0;
+        };
+
+        /// <summary>
+        /// Create empty registry.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="residency"> Manager loaded assets are registered in</param>
+        AssetRegistry(Device& device, ResidencyManager& residency);
+
+        AssetRegistry(const AssetRegistry&) = delete;
+        AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+        /// <summary>
+        /// Get model of OBJ file, it is loaded only if no model of same path or content was loaded
+        /// in same vertex format and streams.
+        /// </summary>
+        /// <param name="filepath"> Path to model data</param>
+        /// <param name="vertexFormat"> Layout of vertices in vertex buffer</param>
+        /// <param name="vertexStreams"> Bindings attributes are split into</param>
+        /// <returns> Shared model</returns>
+        /// <exception cref="std::runtime_error"> File can't be read</exception>
+        std::shared_ptr<Model> LoadModel(const std::string& filepath,
+                                         Model::VertexFormat vertexFormat = Model::VertexFormat::Full,
+                                         Model::VertexStreams vertexStreams = Model::VertexStreams::Interleaved);
+
+        /// <summary>
+        /// Get texture of image file, it is loaded only if no texture of same path or content was loaded.
+        /// </summary>
+        /// <param name="filepath"> Path to image</param>
+        /// <returns> Shared texture</returns>
+        /// <exception cref="std::runtime_error"> File can't be read</exception>
+        std::shared_ptr<Image> LoadTexture(const std::string& filepath);
+
+        /// <summary>
+        /// Drop asset loaded from path, in every vertex format for models. Handles held elsewhere stay valid,
+        /// device memory is released with last of them. Next load of path loads file again.
+        /// </summary>
+        /// <param name="filepath"> Path asset was requested with, other requested paths of same content are dropped too</param>
+        /// <returns> Number of unloaded assets</returns>
+        uint32_t Unload(const std::string& filepath);
+
+        /// <summary>
+        /// Drop all assets without handles outside of registry, their device memory is released.
+        /// </summary>
+        /// <returns> Number of unloaded assets</returns>
+        uint32_t UnloadUnused();
+
+        /// <summary>
+        /// Residency and memory of every loaded asset.
+        /// </summary>
+        std::vector<AssetInfo> GetAssets() const;
+
+        const Statistics& GetStatistics() const
+        {
+            return statistics;
+        }
+
+    private:
+        struct Asset
+        {
+            AssetType type;
+            std::string path;
+            uint64_t contentHash;
+            std::shared_ptr<EvictableResource> resource;
+        };
+
+        /// <summary>
+        /// Absolute path with dot segments removed and symbolic links resolved as far as path exists,
+        /// so different spellings of same file give same key.
+        /// </summary>
+        static std::string NormalizePath(const std::string& filepath);
+
+        /// <summary>
+        /// Hash of size and content of file.
+        /// </summary>
+        static uint64_t HashContent(const MappedFile& file);
+
+        /// <summary>
+        /// Check if file has same bytes as mapped file, file which can't be read differs.
+        /// </summary>
+        static bool HasSameContent(const std::string& filepath, const MappedFile& file);
+
+        /// <summary>
+        /// Find asset by path or content under given variant, e.g. vertex format of model, and load it
+        /// with load if none is found.
+        /// </summary>
+        template <typename T, typename Load>
+        std::shared_ptr<T> FindOrLoad(AssetType type, const std::string& variant, const std::string& filepath,
+                                      Load load);
+
+        /// <summary>
+        /// Remove asset with given content key and all paths leading to it.
+        /// </summary>
+        void Remove(const std::string& contentKey);
+
+        Device& device;
+        ResidencyManager& residency;
+        // Assets by variant, content size and hash, numbered when different contents collide
+        std::unordered_map<std::string, Asset> assets;
+        // Content key of asset by variant and normalized path
+        std::unordered_map<std::string, std::string> paths;
+        Statistics statistics;
+    };
+}
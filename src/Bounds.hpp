@@ -0,0 +1,143 @@
+#pragma once
+#include <limits>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Axis aligned bounding box. Default box is empty, extending it by first point makes it that point.
+    /// </summary>
+    struct BoundingBox
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        void Extend(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        bool IsEmpty() const
+        {
+            return min.x > max.x || min.y > max.y || min.z > max.z;
+        }
+
+        glm::vec3 GetExtent() const
+        {
+            return max - min;
+        }
+
+        glm::vec3 GetCenter() const
+        {
+            return (min + max) * 0.5f;
+        }
+
+        /// <summary>
+        /// Box enclosing this box transformed by affine matrix (Arvo 1990), empty box stays empty.
+        /// </summary>
+        BoundingBox Transform(const glm::mat4& matrix) const
+        {
+            if (IsEmpty())
+            {
+                return *this;
+            }
+            BoundingBox result;
+            result.min = glm::vec3{matrix[3]};
+            result.max = result.min;
+            for (int column = 0; column < 3; column++)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    float a = matrix[column][row] * min[column];
+                    float b = matrix[column][row] * max[column];
+                    result.min[row] += glm::min(a, b);
+                    result.max[row] += glm::max(a, b);
+                }
+            }
+            return result;
+        }
+    };
+
+    /// <summary>
+    /// Bounding sphere. Default sphere is empty.
+    /// </summary>
+    struct BoundingSphere
+    {
+        glm::vec3 center{0.f};
+        float radius = -1.f;
+
+        bool IsEmpty() const
+        {
+            return radius < 0.f;
+        }
+
+        /// <summary>
+        /// Sphere enclosing this sphere transformed by affine matrix, radius is scaled by largest axis scale.
+        /// </summary>
+        BoundingSphere Transform(const glm::mat4& matrix) const
+        {
+            if (IsEmpty())
+            {
+                return *this;
+            }
+            float scale = glm::max(glm::dot(glm::vec3{matrix[0]}, glm::vec3{matrix[0]}),
+                                   glm::max(glm::dot(glm::vec3{matrix[1]}, glm::vec3{matrix[1]}),
+                                            glm::dot(glm::vec3{matrix[2]}, glm::vec3{matrix[2]})));
+            return {glm::vec3{matrix * glm::vec4{center, 1.f}}, radius * glm::sqrt(scale)};
+        }
+    };
+
+    /// <summary>
+    /// Planes of view frustum, xyz is normal pointing inside and w distance from origin. Planes are normalized,
+    /// so plane equation gives signed distance.
+    /// </summary>
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+
+        /// <summary>
+        /// Extract planes from projection matrix (Gribb and Hartmann), depth range is zero to one. Planes are
+        /// in space matrix transforms from, so projection * view * model gives planes in model space.
+        /// </summary>
+        static Frustum FromMatrix(const glm::mat4& matrix)
+        {
+            glm::vec4 rows[4];
+            for (int i = 0; i < 4; i++)
+            {
+                rows[i] = glm::vec4{matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]};
+            }
+
+            Frustum frustum{};
+            frustum.planes[0] = rows[3] + rows[0];
+            frustum.planes[1] = rows[3] - rows[0];
+            frustum.planes[2] = rows[3] + rows[1];
+            frustum.planes[3] = rows[3] - rows[1];
+            frustum.planes[4] = rows[2];
+            frustum.planes[5] = rows[3] - rows[2];
+            for (auto& plane : frustum.planes)
+            {
+                plane /= glm::length(glm::vec3{plane});
+            }
+            return frustum;
+        }
+
+        /// <summary>
+        /// Check if sphere is at least partially inside frustum, spheres near corners may pass too.
+        /// </summary>
+        bool IsSphereVisible(const glm::vec3& center, float radius) const
+        {
+            for (const auto& plane : planes)
+            {
+                if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
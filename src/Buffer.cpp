@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Buffer.hpp"
+#include "Profiler.hpp"
 
 namespace VulkanEngine
 {
@@ -34,27 +35,34 @@ namespace VulkanEngine
     Buffer::~Buffer()
     {
         Unmap();
-        vkDestroyBuffer(device.GetDevice(), buffer, nullptr);
-        vkFreeMemory(device.GetDevice(), memory, nullptr);
+        // Frames in flight may still read buffer
+        device.GetDeletionQueue().Push([device = &device, buffer = buffer, memory = memory]() mutable
+        {
+            vkDestroyBuffer(device->GetDevice(), buffer, nullptr);
+            device->FreeMemory(memory);
+        });
     }
 
     VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(buffer && memory);
-        return vkMapMemory(device.GetDevice(), memory, offset, size, 0, &mapped);
+        // Host visible memory is mapped by allocator for its whole lifetime.
+        assert(buffer && memory.memory);
+        if (memory.mapped == nullptr)
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(memory.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     void Buffer::Unmap()
     {
-        if (mapped)
-        {
-            vkUnmapMemory(device.GetDevice(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     void Buffer::WriteToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset)
     {
+        PROFILE_SCOPE("Buffer::WriteToBuffer");
         assert(mapped);
 
         if (size == VK_WHOLE_SIZE)
@@ -72,23 +80,13 @@ namespace VulkanEngine
 
     VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(device.GetDevice(), 1, &mappedRange);
+        return device.FlushMemory(memory, size, offset);
     }
 
 
     VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(device.GetDevice(), 1, &mappedRange);
+        return device.InvalidateMemory(memory, size, offset);
     }
 
     VkDescriptorBufferInfo Buffer::DescriptorInfo(VkDeviceSize size, VkDeviceSize offset)
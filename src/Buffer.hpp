@@ -34,11 +34,11 @@ namespace VulkanEngine
         Buffer& operator=(const Buffer&) = delete;
 
         /// <summary>
-        /// Map buffer.
+        /// Map buffer. Host visible memory stays mapped by allocator, so this only gives pointer to it.
         /// </summary>
         /// <param name="size"> Size of memory to map. By default VK_WHOLE_SIZE</param>
         /// <param name="offset"> Offset of mapping memory.</param>
-        /// <returns> vkMapMemory result. </returns>
+        /// <returns> VK_SUCCESS or VK_ERROR_MEMORY_MAP_FAILED if memory is not host visible. </returns>
         VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
         /// <summary>
@@ -162,7 +162,7 @@ namespace VulkanEngine
         Device& device;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
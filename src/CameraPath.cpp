@@ -0,0 +1,70 @@
+#include "CameraPath.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+namespace VulkanEngine
+{
+    CameraPath& CameraPath::AddKeyFrame(float time, glm::vec3 translation, glm::vec3 rotation)
+    {
+        assert(keyFrames.empty() || time > keyFrames.back().time);
+        keyFrames.push_back({time, translation, rotation});
+        return *this;
+    }
+
+    void CameraPath::Apply(float time, GameObject& object) const
+    {
+        if (keyFrames.empty())
+        {
+            return;
+        }
+        if (keyFrames.size() == 1 || GetDuration() <= 0.f)
+        {
+            object.transform.translation = keyFrames.front().translation;
+            object.transform.rotation = keyFrames.front().rotation;
+            return;
+        }
+
+        time = std::fmod(time, GetDuration());
+
+        // Find first key frame after given time.
+        auto next = std::upper_bound(keyFrames.begin(), keyFrames.end(), time,
+                                     [](float t, const KeyFrame& keyFrame) { return t < keyFrame.time; });
+        if (next == keyFrames.begin())
+        {
+            next++;
+        }
+        if (next == keyFrames.end())
+        {
+            next--;
+        }
+        auto previous = next - 1;
+
+        float factor = (time - previous->time) / (next->time - previous->time);
+        factor = glm::clamp(factor, 0.f, 1.f);
+        object.transform.translation = glm::mix(previous->translation, next->translation, factor);
+        object.transform.rotation = glm::mix(previous->rotation, next->rotation, factor);
+    }
+
+    CameraPath CameraPath::Orbit(glm::vec3 center, float radius, float height, float duration, int steps)
+    {
+        assert(steps > 0);
+        CameraPath path{};
+        for (int i = 0; i <= steps; i++)
+        {
+            float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(steps);
+            glm::vec3 translation = center + glm::vec3(radius * std::sin(angle), height, radius * std::cos(angle));
+
+            // Look at center, yaw is kept unwrapped so interpolation does not jump.
+            glm::vec3 direction = glm::normalize(center - translation);
+            float pitch = std::asin(-direction.y);
+            float yaw = angle + glm::pi<float>();
+
+            path.AddKeyFrame(duration * static_cast<float>(i) / static_cast<float>(steps), translation,
+                             {pitch, yaw, 0.f});
+        }
+        return path;
+    }
+}
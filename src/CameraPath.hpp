@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "GameObject.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Scripted camera movement. Camera transform is linearly interpolated between key frames,
+    /// so replaying the same path with the same time step always gives the same frames.
+    /// </summary>
+    class CameraPath
+    {
+    public:
+        /// <summary>
+        /// Single point of path.
+        /// </summary>
+        struct KeyFrame
+        {
+            float time;
+            glm::vec3 translation;
+            glm::vec3 rotation;
+        };
+
+        /// <summary>
+        /// Add key frame at the end of path.
+        /// </summary>
+        /// <param name="time"> Time of key frame in seconds, must be greater than time of previous one</param>
+        /// <param name="translation"> Camera position</param>
+        /// <param name="rotation"> Camera rotation in YXZ order, same as in TransformComponent</param>
+        /// <returns> Reference to this path</returns>
+        CameraPath& AddKeyFrame(float time, glm::vec3 translation, glm::vec3 rotation);
+
+        /// <summary>
+        /// Apply path at given time to object transform. Path is looped after last key frame.
+        /// </summary>
+        /// <param name="time"> Time from start of path in seconds</param>
+        /// <param name="object"> Object to be transformed, usually camera object</param>
+        void Apply(float time, GameObject& object) const;
+
+        float GetDuration() const
+        {
+            return keyFrames.empty() ? 0.f : keyFrames.back().time;
+        }
+
+        /// <summary>
+        /// Create path going around given point and looking at it.
+        /// </summary>
+        /// <param name="center"> Point to orbit around</param>
+        /// <param name="radius"> Distance from center in XZ plane</param>
+        /// <param name="height"> Camera Y offset from center</param>
+        /// <param name="duration"> Time of one full circle in seconds</param>
+        /// <param name="steps"> Number of key frames in circle</param>
+        /// <returns> Created path</returns>
+        static CameraPath Orbit(glm::vec3 center, float radius, float height, float duration, int steps = 64);
+
+    private:
+        std::vector<KeyFrame> keyFrames;
+    };
+}
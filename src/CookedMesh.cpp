@@ -0,0 +1,250 @@
+#include "CookedMesh.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace VulkanEngine
+{
+    static size_t AlignUp(size_t offset)
+    {
+        return (offset + CookedMesh::SECTION_ALIGNMENT - 1) & ~(CookedMesh::SECTION_ALIGNMENT - 1);
+    }
+
+    // Size and modification time of source file, false if it doesn't exist.
+    static bool GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+    {
+        std::error_code error;
+        size = std::filesystem::file_size(sourcePath, error);
+        if (error)
+        {
+            return false;
+        }
+        auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+        time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        return !error;
+    }
+
+    static bool IsValidLayout(uint32_t vertexFormat, uint32_t vertexStreams)
+    {
+        return vertexFormat < static_cast<uint32_t>(Model::VertexFormat::Count) &&
+            vertexStreams < static_cast<uint32_t>(Model::VertexStreams::Count);
+    }
+
+    std::string CookedMesh::GetPath(const std::string& sourcePath, Model::VertexFormat vertexFormat,
+                                    Model::VertexStreams vertexStreams)
+    {
+        static const char* FORMAT_NAMES[] = {"full", "compact", "compact-color"};
+        static_assert(sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]) ==
+                      static_cast<size_t>(Model::VertexFormat::Count), "every vertex format needs name");
+
+        std::string path = sourcePath + "." + FORMAT_NAMES[static_cast<size_t>(vertexFormat)];
+        if (vertexStreams == Model::VertexStreams::SplitPositions)
+        {
+            path += ".split";
+        }
+        return path + ".vemesh";
+    }
+
+    CookedMesh::Layout CookedMesh::ComputeLayout(const Header& header)
+    {
+        Layout layout{};
+        size_t offset = AlignUp(sizeof(Header));
+        layout.chunks = offset;
+        offset = AlignUp(offset + header.chunkCount * sizeof(Model::Chunk));
+        layout.lods = offset;
+        offset = AlignUp(offset + header.lodCount * sizeof(Model::Lod));
+        layout.meshlets = offset;
+        offset = AlignUp(offset + header.meshletCount * sizeof(Model::Meshlet));
+
+        auto strides = Model::GetStreamStrides(static_cast<Model::VertexFormat>(header.vertexFormat),
+                                               static_cast<Model::VertexStreams>(header.vertexStreams));
+        for (size_t i = 0; i < strides.size(); i++)
+        {
+            layout.streams[i] = offset;
+            offset = AlignUp(offset + header.vertexCount * strides[i]);
+        }
+        layout.indices = offset;
+        layout.size = offset + header.indexCount * sizeof(uint16_t);
+        return layout;
+    }
+
+    bool CookedMesh::IsUpToDate(const std::string& cookedPath, const std::string& sourcePath,
+                                Model::VertexFormat vertexFormat, Model::VertexStreams vertexStreams)
+    {
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        {
+            return false;
+        }
+
+        std::ifstream file{cookedPath, std::ios::binary};
+        Header header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return false;
+        }
+        return header.magic == MAGIC && header.version == VERSION && header.sourceSize == sourceSize &&
+            header.sourceTime == sourceTime && header.vertexFormat == static_cast<uint32_t>(vertexFormat) &&
+            header.vertexStreams == static_cast<uint32_t>(vertexStreams);
+    }
+
+    void CookedMesh::Write(const std::string& cookedPath, const std::string& sourcePath,
+                           Model::VertexFormat vertexFormat, Model::VertexStreams vertexStreams,
+                           const Model::EncodedMesh& mesh)
+    {
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        {
+            throw std::runtime_error("failed to read source file: " + sourcePath);
+        }
+        header.vertexFormat = static_cast<uint32_t>(vertexFormat);
+        header.vertexStreams = static_cast<uint32_t>(vertexStreams);
+        header.vertexCount = mesh.vertexCount;
+        header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        header.chunkCount = static_cast<uint32_t>(mesh.chunks.size());
+        header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+        header.boundsMin = mesh.bounds.min;
+        header.boundsMax = mesh.bounds.max;
+        header.sphereCenter = mesh.sphere.center;
+        header.sphereRadius = mesh.sphere.radius;
+        Layout layout = ComputeLayout(header);
+
+        // Written to temporary file first, so interrupted write never leaves valid looking cooked mesh
+        std::string temporaryPath = cookedPath + ".tmp";
+        {
+            std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+            if (!file)
+            {
+                throw std::runtime_error("failed to open file: " + temporaryPath);
+            }
+            auto writeAt = [&file](size_t offset, const void* data, size_t size)
+            {
+                static const char PADDING[SECTION_ALIGNMENT]{};
+                file.write(PADDING, static_cast<std::streamsize>(offset - static_cast<size_t>(file.tellp())));
+                file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            };
+            writeAt(0, &header, sizeof(header));
+            writeAt(layout.chunks, mesh.chunks.data(), mesh.chunks.size() * sizeof(Model::Chunk));
+            writeAt(layout.lods, mesh.lods.data(), mesh.lods.size() * sizeof(Model::Lod));
+            writeAt(layout.meshlets, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Model::Meshlet));
+            for (size_t i = 0; i < mesh.streams.size(); i++)
+            {
+                writeAt(layout.streams[i], mesh.streams[i].data(), mesh.streams[i].size());
+            }
+            writeAt(layout.indices, mesh.indices.data(), mesh.indices.size() * sizeof(uint16_t));
+            if (!file)
+            {
+                throw std::runtime_error("failed to write file: " + temporaryPath);
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, cookedPath, error);
+        if (error)
+        {
+            // Windows doesn't replace existing file
+            std::filesystem::remove(cookedPath, error);
+            std::filesystem::rename(temporaryPath, cookedPath, error);
+        }
+        if (error)
+        {
+            std::filesystem::remove(temporaryPath, error);
+            throw std::runtime_error("failed to replace file: " + cookedPath);
+        }
+    }
+
+    CookedMesh::CookedMesh(const std::string& cookedPath):
+        file(cookedPath)
+    {
+        if (file.GetSize() < sizeof(Header))
+        {
+            throw std::runtime_error("failed to load cooked mesh, file is truncated: " + cookedPath);
+        }
+        header = reinterpret_cast<const Header*>(file.GetData());
+        if (header->magic != MAGIC || header->version != VERSION ||
+            !IsValidLayout(header->vertexFormat, header->vertexStreams))
+        {
+            throw std::runtime_error("failed to load cooked mesh, unknown format: " + cookedPath);
+        }
+        layout = ComputeLayout(*header);
+        if (file.GetSize() < layout.size)
+        {
+            throw std::runtime_error("failed to load cooked mesh, file is truncated: " + cookedPath);
+        }
+
+        // Corrupted ranges or index values would make GPU read outside of model geometry in its pool page,
+        // each drawn index plus vertex offset of its range must be below vertex count
+        const uint16_t* indices = GetIndices();
+        auto isInRange = [this, indices](uint32_t firstIndex, uint32_t indexCount, uint32_t vertexOffset)
+        {
+            if (firstIndex + static_cast<uint64_t>(indexCount) > header->indexCount ||
+                vertexOffset >= header->vertexCount)
+            {
+                return false;
+            }
+            uint16_t maxIndex = 0;
+            for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+            {
+                maxIndex = std::max(maxIndex, indices[i]);
+            }
+            return maxIndex < header->vertexCount - vertexOffset;
+        };
+        for (uint32_t i = 0; i < header->chunkCount; i++)
+        {
+            const Model::Chunk& chunk = GetChunks()[i];
+            if (!isInRange(chunk.firstIndex, chunk.indexCount, chunk.vertexOffset))
+            {
+                throw std::runtime_error("failed to load cooked mesh, chunk is out of range: " + cookedPath);
+            }
+        }
+        for (uint32_t i = 0; i < header->meshletCount; i++)
+        {
+            const Model::Meshlet& meshlet = GetMeshlets()[i];
+            if (!isInRange(meshlet.firstIndex, meshlet.indexCount, meshlet.vertexOffset))
+            {
+                throw std::runtime_error("failed to load cooked mesh, meshlet is out of range: " + cookedPath);
+            }
+        }
+        for (uint32_t i = 0; i < header->lodCount; i++)
+        {
+            const Model::Lod& lod = GetLods()[i];
+            if (lod.firstChunk + static_cast<uint64_t>(lod.chunkCount) > header->chunkCount ||
+                lod.firstMeshlet + static_cast<uint64_t>(lod.meshletCount) > header->meshletCount)
+            {
+                throw std::runtime_error("failed to load cooked mesh, LOD is out of range: " + cookedPath);
+            }
+        }
+    }
+
+    const Model::Chunk* CookedMesh::GetChunks() const
+    {
+        return reinterpret_cast<const Model::Chunk*>(file.GetData() + layout.chunks);
+    }
+
+    const Model::Lod* CookedMesh::GetLods() const
+    {
+        return reinterpret_cast<const Model::Lod*>(file.GetData() + layout.lods);
+    }
+
+    const Model::Meshlet* CookedMesh::GetMeshlets() const
+    {
+        return reinterpret_cast<const Model::Meshlet*>(file.GetData() + layout.meshlets);
+    }
+
+    const void* CookedMesh::GetStream(uint32_t stream) const
+    {
+        return file.GetData() + layout.streams[stream];
+    }
+
+    const uint16_t* CookedMesh::GetIndices() const
+    {
+        return reinterpret_cast<const uint16_t*>(file.GetData() + layout.indices);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.hpp"
+#include "Model.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Binary mesh file holding encoded mesh of Model in one vertex format and stream layout, so it can be
+    /// uploaded straight from memory mapping. File is header followed by chunks, LODs, meshlets, vertex streams and
+    /// 16 bit indices, each section aligned to SECTION_ALIGNMENT. All values are little endian.
+    /// </summary>
+    class CookedMesh
+    {
+    public:
+        // "VMSH"
+        static constexpr uint32_t MAGIC = 0x48534d56;
+        // Bump on every change of layout, older files are cooked again
+        static constexpr uint32_t VERSION = 4;
+        static constexpr size_t SECTION_ALIGNMENT = 16;
+        static constexpr uint32_t MAX_STREAMS = 2;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            // Source file mesh was cooked from, cooked mesh is stale once either changes
+            uint64_t sourceSize;
+            int64_t sourceTime;
+            uint32_t vertexFormat;
+            uint32_t vertexStreams;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t chunkCount;
+            uint32_t lodCount;
+            uint32_t meshletCount;
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            glm::vec3 sphereCenter;
+            float sphereRadius;
+        };
+
+        /// <summary>
+        /// Path of cooked mesh of source file, each vertex format and stream layout has own file.
+        /// </summary>
+        static std::string GetPath(const std::string& sourcePath, Model::VertexFormat vertexFormat,
+                                   Model::VertexStreams vertexStreams);
+
+        /// <summary>
+        /// Check if cooked mesh exists, has current version and layout and matches source file.
+        /// </summary>
+        static bool IsUpToDate(const std::string& cookedPath, const std::string& sourcePath,
+                               Model::VertexFormat vertexFormat, Model::VertexStreams vertexStreams);
+
+        /// <summary>
+        /// Write cooked mesh, file is replaced only once it is complete.
+        /// </summary>
+        /// <param name="cookedPath"> Path of cooked mesh</param>
+        /// <param name="sourcePath"> File mesh was loaded from</param>
+        /// <param name="vertexFormat"> Vertex format mesh is encoded in</param>
+        /// <param name="vertexStreams"> Stream layout mesh is encoded in</param>
+        /// <param name="mesh"> Encoded mesh</param>
+        /// <exception cref="std::runtime_error"> File can't be written</exception>
+        static void Write(const std::string& cookedPath, const std::string& sourcePath,
+                          Model::VertexFormat vertexFormat, Model::VertexStreams vertexStreams,
+                          const Model::EncodedMesh& mesh);
+
+        /// <summary>
+        /// Map cooked mesh, data stays valid until object is destroyed.
+        /// </summary>
+        /// <param name="cookedPath"> Path of cooked mesh</param>
+        /// <exception cref="std::runtime_error"> File can't be mapped or is corrupted</exception>
+        explicit CookedMesh(const std::string& cookedPath);
+
+        const Header& GetHeader() const
+        {
+            return *header;
+        }
+
+        const Model::Chunk* GetChunks() const;
+        const Model::Lod* GetLods() const;
+        const Model::Meshlet* GetMeshlets() const;
+        const void* GetStream(uint32_t stream) const;
+        const uint16_t* GetIndices() const;
+
+    private:
+        struct Layout
+        {
+            size_t chunks = 0;
+            size_t lods = 0;
+            size_t meshlets = 0;
+            size_t streams[MAX_STREAMS]{};
+            size_t indices = 0;
+            size_t size = 0;
+        };
+
+        /// <summary>
+        /// Offsets of sections of file with given header.
+        /// </summary>
+        static Layout ComputeLayout(const Header& header);
+
+        MappedFile file;
+        const Header* header = nullptr;
+        Layout layout;
+    };
+}
@@ -0,0 +1,81 @@
+#include "DeletionQueue.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace VulkanEngine
+{
+    DeletionQueue::~DeletionQueue()
+    {
+        Flush();
+    }
+
+    void DeletionQueue::Push(std::function<void()> deleter)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (framesInFlight > 0)
+            {
+                entries.push_back({currentFrame, std::move(deleter)});
+                return;
+            }
+        }
+        deleter();
+    }
+
+    void DeletionQueue::SetFramesInFlight(uint32_t count)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        framesInFlight = count;
+    }
+
+    void DeletionQueue::BeginFrame()
+    {
+        uint64_t retiredFrame;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            // Fence of this slot was signaled by frame submitted framesInFlight frames ago.
+            if (currentFrame < framesInFlight)
+            {
+                return;
+            }
+            retiredFrame = currentFrame - framesInFlight;
+        }
+        Retire(retiredFrame);
+    }
+
+    void DeletionQueue::EndFrame()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        currentFrame++;
+    }
+
+    void DeletionQueue::Flush()
+    {
+        Retire(std::numeric_limits<uint64_t>::max());
+    }
+
+    void DeletionQueue::Retire(uint64_t frame)
+    {
+        // Deleters run outside of lock, they may destroy objects which push to queue again.
+        std::vector<std::function<void()>> retired;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            while (!entries.empty() && entries.front().frame <= frame)
+            {
+                retired.push_back(std::move(entries.front().deleter));
+                entries.pop_front();
+            }
+        }
+        for (auto& deleter : retired)
+        {
+            deleter();
+        }
+    }
+
+    size_t DeletionQueue::GetPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return entries.size();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Postpones destruction of Vulkan objects until frames which may use them finished on GPU, so resources
+    /// can be released mid-session without vkDeviceWaitIdle. Destruction pushed during frame N runs once
+    /// frame N is retired, i.e. when renderer waited for fence of its frame in flight slot.
+    /// Without renderer (no frames in flight) everything is destroyed immediately.
+    /// </summary>
+    class DeletionQueue
+    {
+    public:
+        DeletionQueue() = default;
+        ~DeletionQueue();
+
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+        /// <summary>
+        /// Destroy objects when current frame retires.
+        /// </summary>
+        /// <param name="deleter"> Function destroying objects</param>
+        void Push(std::function<void()> deleter);
+
+        /// <summary>
+        /// Set number of frames which can be in flight, 0 when nothing is rendered. Renderer sets it.
+        /// </summary>
+        /// <param name="count"> Number of frames in flight</param>
+        void SetFramesInFlight(uint32_t count);
+
+        /// <summary>
+        /// Called after waiting for fence of current frame in flight slot, destroys objects of frame which used it.
+        /// </summary>
+        void BeginFrame();
+
+        /// <summary>
+        /// Called after frame was submitted.
+        /// </summary>
+        void EndFrame();
+
+        /// <summary>
+        /// Destroy everything, GPU must be idle.
+        /// </summary>
+        void Flush();
+
+        size_t GetPendingCount() const;
+
+    private:
+        struct Entry
+        {
+            uint64_t frame;
+            std::function<void()> deleter;
+        };
+
+        /// <summary>
+        /// Destroy objects of frames up to given one, including.
+        /// </summary>
+        void Retire(uint64_t frame);
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;
+        uint64_t currentFrame = 0;
+        uint32_t framesInFlight = 0;
+    };
+}
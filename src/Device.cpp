@@ -1,4 +1,7 @@
 #include "Device.hpp"
+#include "Profiler.hpp"
+#include "UploadContext.hpp"
+#include "GeometryPool.hpp"
 
 // std headers
 #include <cstring>
@@ -54,7 +57,17 @@ namespace VulkanEngine
     }
 
     // class member functions
-    Device::Device(Window& window) : window{window}
+    Device::Device(Window& window) : window{&window}
+    {
+        Init();
+    }
+
+    Device::Device()
+    {
+        Init();
+    }
+
+    void Device::Init()
     {
         CreateInstance();
         SetupDebugMessenger();
@@ -62,10 +75,21 @@ namespace VulkanEngine
         PickPhysicalDevice();
         CreateLogicalDevice();
         CreateCommandPool();
+        CreateAllocator();
+        CreateUploadContext();
+        CreateGeometryPool();
     }
 
     Device::~Device()
     {
+        // Waits for pending uploads and frees their staging memory, so it must go before allocator
+        uploadContext.reset();
+        // Postponed frees of geometry go to pool, its buffers are destroyed by second flush
+        deletionQueue.Flush();
+        geometryPool.reset();
+        deletionQueue.Flush();
+        memoryTracker->WriteReport(std::cout);
+        allocator.reset();
         vkDestroyCommandPool(device, commandPool, nullptr);
         vkDestroyDevice(device, nullptr);
 
@@ -74,7 +98,10 @@ namespace VulkanEngine
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface, nullptr);
+        if (surface != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -91,7 +118,8 @@ namespace VulkanEngine
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.1 for vkGetPhysicalDeviceMemoryProperties2 used with memory budget
+        appInfo.apiVersion = VK_API_VERSION_1_1;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -159,7 +187,15 @@ namespace VulkanEngine
         QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily};
+        if (indices.presentFamilyHasValue)
+        {
+            uniqueQueueFamilies.insert(indices.presentFamily);
+        }
+        if (indices.transferFamilyHasValue)
+        {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -172,8 +208,13 @@ namespace VulkanEngine
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // Optional, used only for profiling
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -182,8 +223,17 @@ namespace VulkanEngine
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        enabledFeatures = deviceFeatures;
+        auto extensions = GetRequiredDeviceExtensions();
+        // Optional, without it memory budget is estimated from heap sizes
+        memoryBudgetSupported = properties.apiVersion >= VK_API_VERSION_1_1 &&
+            IsDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memoryBudgetSupported)
+        {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -203,7 +253,24 @@ namespace VulkanEngine
         }
 
         vkGetDeviceQueue(device, indices.graphicsFamily, 0, &graphicsQueue);
-        vkGetDeviceQueue(device, indices.presentFamily, 0, &presentQueue);
+        if (indices.presentFamilyHasValue)
+        {
+            vkGetDeviceQueue(device, indices.presentFamily, 0, &presentQueue);
+        }
+
+        graphicsQueueFamily = indices.graphicsFamily;
+        if (indices.transferFamilyHasValue)
+        {
+            transferQueueFamily = indices.transferFamily;
+            vkGetDeviceQueue(device, indices.transferFamily, 0, &transferQueue);
+        }
+        else
+        {
+            transferQueueFamily = indices.graphicsFamily;
+            transferQueue = graphicsQueue;
+        }
+        std::cout << "transfer queue family: " << transferQueueFamily
+            << (HasDedicatedTransferQueue() ? " (dedicated)" : " (graphics)") << std::endl;
     }
 
     void Device::CreateCommandPool()
@@ -224,7 +291,12 @@ namespace VulkanEngine
 
     void Device::CreateSurface()
     {
-        window.CreateWindowSurface(instance, &surface);
+        // Headless device renders only offscreen, so there is nothing to present to.
+        if (IsHeadless())
+        {
+            return;
+        }
+        window->CreateWindowSurface(instance, &surface);
     }
 
     bool Device::IsDeviceSuitable(VkPhysicalDevice device)
@@ -233,8 +305,8 @@ namespace VulkanEngine
 
         bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        bool swapChainAdequate = IsHeadless();
+        if (extensionsSupported && !IsHeadless())
         {
             SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -243,7 +315,7 @@ namespace VulkanEngine
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-        return indices.isComplete() && extensionsSupported && swapChainAdequate &&
+        return indices.isComplete(!IsHeadless()) && extensionsSupported && swapChainAdequate &&
             supportedFeatures.samplerAnisotropy;
     }
 
@@ -304,11 +376,16 @@ namespace VulkanEngine
 
     std::vector<const char*> Device::GetRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        std::vector<const char*> extensions;
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        // Glfw is not initialized for headless device, so its surface extensions are not needed.
+        if (!IsHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers)
         {
@@ -345,6 +422,15 @@ namespace VulkanEngine
         }
     }
 
+    std::vector<const char*> Device::GetRequiredDeviceExtensions()
+    {
+        if (IsHeadless())
+        {
+            return {};
+        }
+        return deviceExtensions;
+    }
+
     bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice device)
     {
         uint32_t extensionCount;
@@ -357,7 +443,8 @@ namespace VulkanEngine
             &extensionCount,
             availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        auto extensions = GetRequiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
         for (const auto& extension : availableExtensions)
         {
@@ -367,6 +454,24 @@ namespace VulkanEngine
         return requiredExtensions.empty();
     }
 
+    bool Device::IsDeviceExtensionSupported(VkPhysicalDevice device, const char* extension)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& available : availableExtensions)
+        {
+            if (strcmp(available.extensionName, extension) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -385,14 +490,18 @@ namespace VulkanEngine
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport)
+            // Without surface there is no present queue to look for.
+            if (!IsHeadless())
             {
-                indices.presentFamily = i;
-                indices.presentFamilyHasValue = true;
+                VkBool32 presentSupport = false;
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+                if (queueFamily.queueCount > 0 && presentSupport)
+                {
+                    indices.presentFamily = i;
+                    indices.presentFamilyHasValue = true;
+                }
             }
-            if (indices.isComplete())
+            if (indices.isComplete(!IsHeadless()))
             {
                 break;
             }
@@ -400,9 +509,38 @@ namespace VulkanEngine
             i++;
         }
 
+        // Prefer family with transfer only, then any without graphics. Compute queues may be busy with
+        // async compute, while transfer only family maps to copy engine.
+        for (int pass = 0; pass < 2 && !indices.transferFamilyHasValue; pass++)
+        {
+            VkQueueFlags excluded = pass == 0 ? VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT : VK_QUEUE_GRAPHICS_BIT;
+            for (uint32_t family = 0; family < queueFamilyCount; family++)
+            {
+                const auto& queueFamily = queueFamilies[family];
+                if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+                    (queueFamily.queueFlags & excluded) == 0)
+                {
+                    indices.transferFamily = family;
+                    indices.transferFamilyHasValue = true;
+                    break;
+                }
+            }
+        }
+
         return indices;
     }
 
+    VkQueueFamilyProperties Device::GetQueueFamilyProperties(uint32_t queueFamily)
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        return queueFamilies.at(queueFamily);
+    }
+
     SwapChainSupportDetails Device::QuerySwapChainSupport(VkPhysicalDevice device)
     {
         SwapChainSupportDetails details;
@@ -453,6 +591,14 @@ namespace VulkanEngine
         throw std::runtime_error("failed to find supported format!");
     }
 
+    VkFormat Device::FindDepthFormat()
+    {
+        return FindSupportedFormat(
+            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    }
+
     uint32_t Device::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
         VkPhysicalDeviceMemoryProperties memProperties;
@@ -469,12 +615,136 @@ namespace VulkanEngine
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
+    void Device::CreateAllocator()
+    {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+        std::vector<uint32_t> memoryTypeHeaps(memProperties.memoryTypeCount);
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+        {
+            memoryTypeHeaps[i] = memProperties.memoryTypes[i].heapIndex;
+        }
+        std::vector<uint64_t> heapSizes(memProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++)
+        {
+            heapSizes[i] = memProperties.memoryHeaps[i].size;
+        }
+
+        memoryTracker = std::make_unique<MemoryTracker>(std::move(memoryTypeHeaps), std::move(heapSizes),
+                                                        properties.limits.maxMemoryAllocationCount);
+        allocator = std::make_unique<MemoryAllocator>(device, physicalDevice, *memoryTracker);
+        UpdateMemoryBudget();
+    }
+
+    void Device::UpdateMemoryBudget()
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 memProperties{};
+        memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        if (memoryBudgetSupported)
+        {
+            memProperties.pNext = &budgetProperties;
+            vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties);
+        }
+        else
+        {
+            vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties.memoryProperties);
+        }
+
+        uint32_t heapCount = memProperties.memoryProperties.memoryHeapCount;
+        memoryBudget.resize(heapCount);
+        for (uint32_t i = 0; i < heapCount; i++)
+        {
+            const VkMemoryHeap& heap = memProperties.memoryProperties.memoryHeaps[i];
+            memoryBudget[i].flags = heap.flags;
+            if (memoryBudgetSupported)
+            {
+                memoryBudget[i].budget = budgetProperties.heapBudget[i];
+                memoryBudget[i].usage = budgetProperties.heapUsage[i];
+            }
+            else
+            {
+                // Only own allocations are known, other processes are not accounted for.
+                memoryBudget[i].budget = static_cast<VkDeviceSize>(heap.size * ESTIMATED_BUDGET_RATIO);
+                memoryBudget[i].usage = memoryTracker->GetHeapUsage(i).currentBytes;
+            }
+        }
+    }
+
+    void Device::CreateUploadContext()
+    {
+        uploadContext = std::make_unique<UploadContext>(*this);
+    }
+
+    void Device::CreateGeometryPool()
+    {
+        geometryPool = std::make_unique<GeometryPool>(*this);
+    }
+
+    MemoryAllocation Device::AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                                            MemoryCategory category, bool linear)
+    {
+        uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+        return allocator->Allocate(requirements, memoryType, category, linear);
+    }
+
+    void Device::FreeMemory(MemoryAllocation& allocation)
+    {
+        allocator->Free(allocation);
+    }
+
+    VkResult Device::FlushMemory(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        return allocator->Flush(allocation, size, offset);
+    }
+
+    VkResult Device::InvalidateMemory(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        return allocator->Invalidate(allocation, size, offset);
+    }
+
+    static MemoryCategory BufferMemoryCategory(VkBufferUsageFlags usage)
+    {
+        if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+        {
+            return MemoryCategory::Vertex;
+        }
+        if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+        {
+            return MemoryCategory::Index;
+        }
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+        {
+            return MemoryCategory::Uniform;
+        }
+        if (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+        {
+            return MemoryCategory::Staging;
+        }
+        return MemoryCategory::Other;
+    }
+
+    static MemoryCategory ImageMemoryCategory(VkImageUsageFlags usage)
+    {
+        if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+        {
+            return MemoryCategory::Attachment;
+        }
+        if (usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+        {
+            return MemoryCategory::Texture;
+        }
+        return MemoryCategory::Other;
+    }
+
     void Device::CreateBuffer(
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory)
+        MemoryAllocation& bufferMemory)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -489,18 +759,19 @@ namespace VulkanEngine
 
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        try
+        {
+            bufferMemory = AllocateMemory(memRequirements, properties, BufferMemoryCategory(usage), true);
+        }
+        catch (...)
         {
-            throw std::runtime_error("failed to allocate buffer memory!");
+            // Caller may recover from OutOfMemoryError, so buffer must not leak.
+            vkDestroyBuffer(device, buffer, nullptr);
+            buffer = VK_NULL_HANDLE;
+            throw;
         }
 
-        vkBindBufferMemory(device, buffer, bufferMemory, 0);
+        vkBindBufferMemory(device, buffer, bufferMemory.memory, bufferMemory.offset);
     }
 
     VkCommandBuffer Device::BeginSingleTimeCommands()
@@ -524,6 +795,7 @@ namespace VulkanEngine
 
     void Device::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
     {
+        PROFILE_SCOPE("Device::EndSingleTimeCommands");
         vkEndCommandBuffer(commandBuffer);
 
         VkSubmitInfo submitInfo{};
@@ -582,7 +854,7 @@ namespace VulkanEngine
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory)
+        MemoryAllocation& imageMemory)
     {
         if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
         {
@@ -591,18 +863,19 @@ namespace VulkanEngine
 
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+        try
+        {
+            imageMemory = AllocateMemory(memRequirements, properties, ImageMemoryCategory(imageInfo.usage),
+                                         imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
+        }
+        catch (...)
         {
-            throw std::runtime_error("failed to allocate image memory!");
+            vkDestroyImage(device, image, nullptr);
+            image = VK_NULL_HANDLE;
+            throw;
         }
 
-        if (vkBindImageMemory(device, image, imageMemory, 0) != VK_SUCCESS)
+        if (vkBindImageMemory(device, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
         }
@@ -1,13 +1,20 @@
 #pragma once
 
 #include "Window.hpp"
+#include "DeletionQueue.hpp"
+#include "MemoryAllocator.hpp"
+#include "MemoryTracker.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace VulkanEngine
 {
+    class UploadContext;
+    class GeometryPool;
+
     struct SwapChainSupportDetails
     {
         VkSurfaceCapabilitiesKHR capabilities;
@@ -19,14 +26,35 @@ namespace VulkanEngine
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // Family with transfer but without graphics, DMA engine on most discrete GPUs
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
-        bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+        bool transferFamilyHasValue = false;
+        bool isComplete(bool requirePresent = true)
+        {
+            return graphicsFamilyHasValue && (presentFamilyHasValue || !requirePresent);
+        }
+    };
+
+    /// <summary>
+    /// Budget and usage of memory heap, reported by VK_EXT_memory_budget or estimated without it.
+    /// </summary>
+    struct HeapBudget
+    {
+        // Memory process can use before driver starts paging or allocations fail
+        VkDeviceSize budget = 0;
+        // Memory used by process, including other processes' view if driver reports it
+        VkDeviceSize usage = 0;
+        VkMemoryHeapFlags flags = 0;
     };
 
     class Device
     {
     public:
+        // Part of heap size used as budget when VK_EXT_memory_budget isn't supported
+        static constexpr double ESTIMATED_BUDGET_RATIO = 0.8;
+
 #ifdef NDEBUG
         const bool enableValidationLayers = false;
 #else
@@ -34,6 +62,12 @@ namespace VulkanEngine
 #endif
 
         Device(Window& window);
+
+        /// <summary>
+        /// Create device without window. No surface and present queue are created,
+        /// so device can be used only for offscreen rendering.
+        /// </summary>
+        Device();
         ~Device();
 
         // Not copyable or movable
@@ -44,15 +78,24 @@ namespace VulkanEngine
 
         VkCommandPool GetCommandPool() const { return commandPool; }
         VkDevice GetDevice() const { return device; }
+        VkPhysicalDevice GetPhysicalDevice() const { return physicalDevice; }
         VkSurfaceKHR Surface() const { return surface; }
         VkQueue GraphicsQueue() const { return graphicsQueue; }
         VkQueue PresentQueue() const { return presentQueue; }
+        // Graphics queue if device has no dedicated transfer family
+        VkQueue TransferQueue() const { return transferQueue; }
+        uint32_t GraphicsQueueFamily() const { return graphicsQueueFamily; }
+        uint32_t TransferQueueFamily() const { return transferQueueFamily; }
+        bool HasDedicatedTransferQueue() const { return transferQueueFamily != graphicsQueueFamily; }
+        bool IsHeadless() const { return window == nullptr; }
 
         SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(physicalDevice); }
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(physicalDevice); }
+        VkQueueFamilyProperties GetQueueFamilyProperties(uint32_t queueFamily);
         VkFormat FindSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+        VkFormat FindDepthFormat();
 
         // Buffer Helper Functions
         void CreateBuffer(
@@ -60,19 +103,83 @@ namespace VulkanEngine
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            MemoryAllocation& bufferMemory);
         VkCommandBuffer BeginSingleTimeCommands();
         void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
         void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
         void CopyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
+        /// <summary>
+        /// Sub-allocate memory for resource from memory allocator. All device memory should be allocated here.
+        /// </summary>
+        /// <param name="requirements"> Requirements of resource which will be bound to memory</param>
+        /// <param name="properties"> Required memory properties</param>
+        /// <param name="category"> What memory is used for</param>
+        /// <param name="linear"> true for buffers and linear images, false for optimal tiling images</param>
+        /// <returns> Allocated memory, resource must be bound at its offset</returns>
+        MemoryAllocation AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                                        MemoryCategory category, bool linear);
+
+        /// <summary>
+        /// Free memory allocated with AllocateMemory.
+        /// </summary>
+        /// <param name="allocation"> Memory to free, may be empty. Reset to empty state</param>
+        void FreeMemory(MemoryAllocation& allocation);
+
+        /// <summary>
+        /// Flush host writes to range of allocation, needed only for non-coherent memory.
+        /// </summary>
+        /// <param name="allocation"> Host visible allocation</param>
+        /// <param name="size"> Size of range or VK_WHOLE_SIZE</param>
+        /// <param name="offset"> Offset of range from allocation start</param>
+        /// <returns> Flush result</returns>
+        VkResult FlushMemory(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+        /// <summary>
+        /// Make device writes to range of allocation visible to host, needed only for non-coherent memory.
+        /// </summary>
+        /// <param name="allocation"> Host visible allocation</param>
+        /// <param name="size"> Size of range or VK_WHOLE_SIZE</param>
+        /// <param name="offset"> Offset of range from allocation start</param>
+        /// <returns> Invalidate result</returns>
+        VkResult InvalidateMemory(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+        /// <summary>
+        /// Get context batching uploads of buffers and images, prefer it to single time command helpers.
+        /// </summary>
+        UploadContext& GetUploadContext() { return *uploadContext; }
+
+        /// <summary>
+        /// Get pool of shared vertex and index buffers, which models are allocated from.
+        /// </summary>
+        GeometryPool& GetGeometryPool() { return *geometryPool; }
+
+        /// <summary>
+        /// Get queue postponing destruction of resources until frames using them finished.
+        /// </summary>
+        DeletionQueue& GetDeletionQueue() { return deletionQueue; }
+
+        /// <summary>
+        /// Query budget and usage of all heaps, should be called once per frame.
+        /// </summary>
+        void UpdateMemoryBudget();
+
+        /// <summary>
+        /// Get budget of each heap from last UpdateMemoryBudget call.
+        /// </summary>
+        const std::vector<HeapBudget>& GetMemoryBudget() const { return memoryBudget; }
+        bool IsMemoryBudgetSupported() const { return memoryBudgetSupported; }
+
+        const MemoryTracker& GetMemoryTracker() const { return *memoryTracker; }
+        const MemoryAllocator& GetMemoryAllocator() const { return *allocator; }
+
         // Image Helper Functions
         void CreateImageWithInfo(
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            MemoryAllocation& imageMemory);
         void TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
                                    VkImageSubresourceRange subresourceRange);
         void CreateImageView(VkImage image, VkFormat format, VkImageView& imageView,
@@ -80,35 +187,55 @@ namespace VulkanEngine
 
         static constexpr  VkImageSubresourceRange defaultSubresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
         VkPhysicalDeviceProperties properties;
+        // Features enabled on logical device, optional ones are enabled only if supported.
+        VkPhysicalDeviceFeatures enabledFeatures{};
 
     private:
+        void Init();
         void CreateInstance();
         void SetupDebugMessenger();
         void CreateSurface();
         void PickPhysicalDevice();
         void CreateLogicalDevice();
         void CreateCommandPool();
+        void CreateAllocator();
+        void CreateUploadContext();
+        void CreateGeometryPool();
 
         // helper functions
         bool IsDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char*> GetRequiredExtensions();
+        std::vector<const char*> GetRequiredDeviceExtensions();
         bool CheckValidationLayerSupport();
         QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device);
         void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void HasGflwRequiredInstanceExtensions();
         bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+        bool IsDeviceExtensionSupported(VkPhysicalDevice device, const char* extension);
         SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        Window& window;
+        Window* window = nullptr;
         VkCommandPool commandPool;
 
         VkDevice device;
-        VkSurfaceKHR surface;
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
         VkQueue graphicsQueue;
-        VkQueue presentQueue;
+        VkQueue presentQueue = VK_NULL_HANDLE;
+        VkQueue transferQueue;
+        uint32_t graphicsQueueFamily;
+        uint32_t transferQueueFamily;
+
+        std::unique_ptr<MemoryTracker> memoryTracker;
+        std::unique_ptr<MemoryAllocator> allocator;
+        std::unique_ptr<UploadContext> uploadContext;
+        std::unique_ptr<GeometryPool> geometryPool;
+        DeletionQueue deletionQueue;
+
+        bool memoryBudgetSupported = false;
+        std::vector<HeapBudget> memoryBudget;
 
         const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_monitor"};
         const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
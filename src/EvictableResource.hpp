@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+#include "UploadContext.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// GPU resource which can release its device memory and load it again from its source.
+    /// ResidencyManager decides when.
+    /// </summary>
+    class EvictableResource
+    {
+    public:
+        virtual ~EvictableResource() = default;
+
+        /// <summary>
+        /// Resource can be evicted only if it knows how to restore itself, e.g. has file it was loaded from.
+        /// </summary>
+        virtual bool CanEvict() const = 0;
+
+        /// <summary>
+        /// Device memory of resource is allocated, upload may still be in progress.
+        /// </summary>
+        virtual bool IsResident() const = 0;
+
+        /// <summary>
+        /// Release device memory, destruction is postponed until frames in flight finished.
+        /// </summary>
+        /// <returns> Bytes of device memory released, memory shared with resident resources isn't counted</returns>
+        virtual VkDeviceSize Evict() = 0;
+
+        /// <summary>
+        /// Load resource from its source again and record upload.
+        /// </summary>
+        /// <exception cref="OutOfMemoryError"> Device memory is exhausted, resource stays evicted</exception>
+        virtual void Restore() = 0;
+
+        /// <summary>
+        /// Device memory used by resource, or used before eviction.
+        /// </summary>
+        virtual VkDeviceSize GetMemorySize() const = 0;
+
+        /// <summary>
+        /// Token of last upload of resource data, it can be used when token is complete.
+        /// </summary>
+        virtual UploadToken GetUploadToken() const = 0;
+
+        /// <summary>
+        /// Resources with same nonzero key share device memory, which is released only when all of them are
+        /// evicted. 0 means memory of resource is its own.
+        /// </summary>
+        virtual uint64_t GetSharedMemoryKey() const
+        {
+            return 0;
+        }
+
+        /// <summary>
+        /// Number of resident resources sharing memory of GetSharedMemoryKey, including ones not registered in
+        /// ResidencyManager.
+        /// </summary>
+        virtual uint32_t GetSharedMemoryUserCount() const
+        {
+            return 1;
+        }
+
+    private:
+        friend class ResidencyManager;
+
+        // Maintained by ResidencyManager
+        uint64_t lastUsedFrame = 0;
+        uint64_t restoreRetryFrame = 0;
+    };
+}
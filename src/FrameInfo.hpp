@@ -1,6 +1,8 @@
 #pragma once
 #include "Camera.hpp"
 #include "Descriptors.hpp"
+#include "FrameRingBuffer.hpp"
+#include "ResidencyManager.hpp"
 #include <vulkan/vulkan.h>
 
 namespace VulkanEngine
@@ -14,8 +16,16 @@ namespace VulkanEngine
         int frameIndex;
         float frameTime;
         Camera& camera;
+        // Size of rendered image in pixels
+        VkExtent2D extent;
         VkCommandBuffer commandBuffer;
         VkDescriptorSet globalDescriptorSet;
+        // Dynamic offset of GlobalUbo in frame data, bound with global descriptor set
+        uint32_t globalUboOffset;
+        // Transient data of this frame
+        FrameRingBuffer& frameData;
         GameObject::Map& gameObjects;
+        // Resources have to be requested before they are drawn
+        ResidencyManager& residency;
     };
 }
@@ -0,0 +1,60 @@
+#include "FrameRingBuffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace VulkanEngine
+{
+    static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    FrameRingBuffer::FrameRingBuffer(Device& device, VkDeviceSize frameSize, uint32_t framesInFlight,
+                                     VkDeviceSize descriptorRange):
+        alignment(std::max<VkDeviceSize>(device.properties.limits.minUniformBufferOffsetAlignment, 1)),
+        descriptorRange(descriptorRange),
+        framesInFlight(framesInFlight)
+    {
+        this->frameSize = AlignUp(frameSize, alignment);
+
+        // Last allocation of last frame still needs whole descriptor range inside buffer.
+        VkDeviceSize bufferSize = this->frameSize * framesInFlight + descriptorRange;
+        buffer = std::make_unique<Buffer>(
+            device,
+            bufferSize,
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (buffer->Map() != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to map frame ring buffer!");
+        }
+    }
+
+    void FrameRingBuffer::BeginFrame(int frameIndex)
+    {
+        assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < framesInFlight);
+        frameStart = frameSize * frameIndex;
+        head = frameStart;
+    }
+
+    FrameRingBuffer::Allocation FrameRingBuffer::Allocate(VkDeviceSize size)
+    {
+        assert(size <= descriptorRange && "allocation is bigger than descriptor range");
+        VkDeviceSize offset = head;
+        if (offset + size > frameStart + frameSize)
+        {
+            throw std::runtime_error("frame ring buffer is full!");
+        }
+        head = AlignUp(offset + size, alignment);
+
+        return {static_cast<char*>(buffer->GetMappedMemory()) + offset, static_cast<uint32_t>(offset)};
+    }
+
+    VkDescriptorBufferInfo FrameRingBuffer::DescriptorInfo()
+    {
+        return buffer->DescriptorInfo(descriptorRange, 0);
+    }
+}
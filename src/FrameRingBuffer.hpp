@@ -0,0 +1,89 @@
+#pragma once
+#include <cstring>
+#include <memory>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Persistently mapped uniform buffer split to one partition per frame in flight. Transient data of frame
+    /// is sub-allocated by bumping pointer in partition of current frame and bound with dynamic descriptor offset,
+    /// so writing new data needs no allocation, mapping or descriptor update. Partition is reused once
+    /// its frame fence was waited, i.e. when BeginFrame is called with its index again.
+    /// </summary>
+    class FrameRingBuffer
+    {
+    public:
+        /// <summary>
+        /// Sub-allocation from current frame partition.
+        /// </summary>
+        struct Allocation
+        {
+            void* data;
+            // Dynamic offset to pass to vkCmdBindDescriptorSets
+            uint32_t offset;
+        };
+
+        /// <summary>
+        /// Create and map ring buffer.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="frameSize"> Bytes available to each frame</param>
+        /// <param name="framesInFlight"> Number of partitions</param>
+        /// <param name="descriptorRange"> Range visible to shader from dynamic offset, largest single allocation</param>
+        FrameRingBuffer(Device& device, VkDeviceSize frameSize, uint32_t framesInFlight,
+                        VkDeviceSize descriptorRange);
+
+        FrameRingBuffer(const FrameRingBuffer&) = delete;
+        FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+        /// <summary>
+        /// Start using partition of given frame, everything allocated in it before is discarded.
+        /// </summary>
+        /// <param name="frameIndex"> Index of frame in flight</param>
+        void BeginFrame(int frameIndex);
+
+        /// <summary>
+        /// Allocate aligned part of current frame partition.
+        /// </summary>
+        /// <param name="size"> Size in bytes, at most descriptor range</param>
+        /// <returns> Pointer to write data to and its dynamic offset</returns>
+        Allocation Allocate(VkDeviceSize size);
+
+        /// <summary>
+        /// Copy data to current frame partition.
+        /// </summary>
+        /// <param name="data"> Data to copy</param>
+        /// <returns> Dynamic offset of copied data</returns>
+        template <typename T>
+        uint32_t Push(const T& data)
+        {
+            Allocation allocation = Allocate(sizeof(T));
+            memcpy(allocation.data, &data, sizeof(T));
+            return allocation.offset;
+        }
+
+        /// <summary>
+        /// Descriptor info to write to VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding.
+        /// </summary>
+        /// <returns> Descriptor of buffer start with descriptor range</returns>
+        VkDescriptorBufferInfo DescriptorInfo();
+
+        VkDeviceSize GetUsedBytes() const
+        {
+            return head - frameStart;
+        }
+
+    private:
+        std::unique_ptr<Buffer> buffer;
+        VkDeviceSize alignment;
+        VkDeviceSize frameSize;
+        VkDeviceSize descriptorRange;
+        uint32_t framesInFlight;
+
+        VkDeviceSize frameStart = 0;
+        VkDeviceSize head = 0;
+    };
+}
@@ -0,0 +1,277 @@
+#include "FrameStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace VulkanEngine
+{
+    // Nearest-rank percentile of sorted values.
+    static double Percentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+        {
+            return 0.0;
+        }
+        auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+        rank = std::clamp<size_t>(rank, 1, sorted.size());
+        return sorted[rank - 1];
+    }
+
+    FrameStatistics::FrameStatistics(uint32_t warmupFrames):
+        warmupFrames(warmupFrames)
+    {
+    }
+
+    void FrameStatistics::AddFrame(double cpuTimeMs, std::vector<ZoneSample> cpuZones)
+    {
+        uint32_t frame = frameCounter++;
+        if (frame < warmupFrames)
+        {
+            return;
+        }
+        frames.push_back({frame, cpuTimeMs, std::move(cpuZones), {}, {}});
+    }
+
+    FrameStatistics::FrameSample* FrameStatistics::FindFrame(uint32_t frame)
+    {
+        // Frames are stored in order without gaps, starting after warmup.
+        if (frame < warmupFrames || frame - warmupFrames >= frames.size())
+        {
+            return nullptr;
+        }
+        return &frames[frame - warmupFrames];
+    }
+
+    void FrameStatistics::AddGpuTimes(uint32_t frame, std::vector<ZoneSample> gpuZones)
+    {
+        if (auto sample = FindFrame(frame))
+        {
+            sample->gpuZones = std::move(gpuZones);
+        }
+    }
+
+    void FrameStatistics::AddPipelineStatistics(uint32_t frame, std::vector<PipelineStatisticsSample> pipelineStatistics)
+    {
+        if (auto sample = FindFrame(frame))
+        {
+            sample->pipelineStatistics = std::move(pipelineStatistics);
+        }
+    }
+
+    std::vector<FrameStatistics::PipelineStatisticsSummary> FrameStatistics::SummarizePipelineStatistics() const
+    {
+        std::vector<PipelineStatisticsSummary> summaries;
+        for (auto& sample : frames)
+        {
+            for (auto& statistics : sample.pipelineStatistics)
+            {
+                auto it = std::find_if(summaries.begin(), summaries.end(),
+                    [&](const PipelineStatisticsSummary& summary) { return summary.name == statistics.name; });
+                if (it == summaries.end())
+                {
+                    summaries.emplace_back();
+                    it = summaries.end() - 1;
+                    it->name = statistics.name;
+                }
+                it->sampleCount++;
+                it->vertexShaderInvocations += static_cast<double>(statistics.vertexShaderInvocations);
+                it->clippingInvocations += static_cast<double>(statistics.clippingInvocations);
+                it->clippingPrimitives += static_cast<double>(statistics.clippingPrimitives);
+                it->fragmentShaderInvocations += static_cast<double>(statistics.fragmentShaderInvocations);
+            }
+        }
+
+        for (auto& summary : summaries)
+        {
+            if (summary.clippingInvocations > 0.0)
+            {
+                summary.clippedRatio = 1.0 - summary.clippingPrimitives / summary.clippingInvocations;
+            }
+            auto count = static_cast<double>(summary.sampleCount);
+            summary.vertexShaderInvocations /= count;
+            summary.clippingInvocations /= count;
+            summary.clippingPrimitives /= count;
+            summary.fragmentShaderInvocations /= count;
+        }
+        return summaries;
+    }
+
+    std::vector<FrameStatistics::ZoneSummary> FrameStatistics::SummarizeZones(
+        std::vector<ZoneSample> FrameSample::* zonesOfFrame) const
+    {
+        std::vector<std::string> names;
+        std::vector<std::vector<double>> times;
+        for (auto& sample : frames)
+        {
+            for (auto& zone : sample.*zonesOfFrame)
+            {
+                auto it = std::find(names.begin(), names.end(), zone.name);
+                if (it == names.end())
+                {
+                    names.emplace_back(zone.name);
+                    times.emplace_back();
+                    it = names.end() - 1;
+                }
+                times[it - names.begin()].push_back(zone.timeMs);
+            }
+        }
+
+        std::vector<ZoneSummary> summaries;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            auto& zoneTimes = times[i];
+            std::sort(zoneTimes.begin(), zoneTimes.end());
+
+            ZoneSummary summary{};
+            summary.name = names[i];
+            summary.sampleCount = zoneTimes.size();
+            for (double time : zoneTimes)
+            {
+                summary.averageMs += time;
+            }
+            summary.averageMs /= static_cast<double>(zoneTimes.size());
+            summary.p50Ms = Percentile(zoneTimes, 50.0);
+            summary.p95Ms = Percentile(zoneTimes, 95.0);
+            summary.maxMs = zoneTimes.back();
+            summaries.push_back(std::move(summary));
+        }
+        return summaries;
+    }
+
+    FrameStatistics::Summary FrameStatistics::Summarize() const
+    {
+        Summary summary{};
+        if (frames.empty())
+        {
+            return summary;
+        }
+
+        std::vector<double> times;
+        times.reserve(frames.size());
+        double total = 0.0;
+        for (auto& sample : frames)
+        {
+            times.push_back(sample.cpuTimeMs);
+            total += sample.cpuTimeMs;
+        }
+        std::sort(times.begin(), times.end());
+
+        summary.frameCount = frames.size();
+        summary.totalTimeSeconds = total / 1000.0;
+        summary.framesPerSecond = total > 0.0 ? static_cast<double>(frames.size()) / summary.totalTimeSeconds : 0.0;
+        summary.minMs = times.front();
+        summary.averageMs = total / static_cast<double>(frames.size());
+        summary.p50Ms = Percentile(times, 50.0);
+        summary.p95Ms = Percentile(times, 95.0);
+        summary.p99Ms = Percentile(times, 99.0);
+        summary.maxMs = times.back();
+        summary.cpuZones = SummarizeZones(&FrameSample::cpuZones);
+        summary.gpuZones = SummarizeZones(&FrameSample::gpuZones);
+        summary.pipelineStatistics = SummarizePipelineStatistics();
+        return summary;
+    }
+
+    static void WriteZoneSummaries(std::ostream& file, const std::vector<FrameStatistics::ZoneSummary>& zones)
+    {
+        file << "{";
+        for (size_t i = 0; i < zones.size(); i++)
+        {
+            auto& zone = zones[i];
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    \"" << zone.name << "\": {\"samples\": " << zone.sampleCount
+                << ", \"average\": " << zone.averageMs
+                << ", \"p50\": " << zone.p50Ms
+                << ", \"p95\": " << zone.p95Ms
+                << ", \"max\": " << zone.maxMs << "}";
+        }
+        file << (zones.empty() ? "}" : "\n  }");
+    }
+
+    static void WriteZones(std::ostream& file, const std::vector<FrameStatistics::ZoneSample>& zones)
+    {
+        file << "{";
+        for (size_t i = 0; i < zones.size(); i++)
+        {
+            file << (i == 0 ? "" : ", ") << "\"" << zones[i].name << "\": " << zones[i].timeMs;
+        }
+        file << "}";
+    }
+
+    static void WritePipelineStatistics(std::ostream& file,
+                                        const std::vector<FrameStatistics::PipelineStatisticsSample>& pipelineStatistics)
+    {
+        file << "{";
+        for (size_t i = 0; i < pipelineStatistics.size(); i++)
+        {
+            auto& statistics = pipelineStatistics[i];
+            file << (i == 0 ? "" : ", ") << "\"" << statistics.name << "\": ["
+                << statistics.vertexShaderInvocations << ", "
+                << statistics.clippingInvocations << ", "
+                << statistics.clippingPrimitives << ", "
+                << statistics.fragmentShaderInvocations << "]";
+        }
+        file << "}";
+    }
+
+    void FrameStatistics::WriteJson(const std::string& filepath) const
+    {
+        std::ofstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file " + filepath);
+        }
+
+        Summary summary = Summarize();
+        file << "{\n";
+        file << "  \"warmupFrames\": " << warmupFrames << ",\n";
+        file << "  \"frameCount\": " << summary.frameCount << ",\n";
+        file << "  \"totalTimeSeconds\": " << summary.totalTimeSeconds << ",\n";
+        file << "  \"framesPerSecond\": " << summary.framesPerSecond << ",\n";
+        file << "  \"cpuTimeMs\": {\n";
+        file << "    \"min\": " << summary.minMs << ",\n";
+        file << "    \"average\": " << summary.averageMs << ",\n";
+        file << "    \"p50\": " << summary.p50Ms << ",\n";
+        file << "    \"p95\": " << summary.p95Ms << ",\n";
+        file << "    \"p99\": " << summary.p99Ms << ",\n";
+        file << "    \"max\": " << summary.maxMs << "\n";
+        file << "  },\n";
+        file << "  \"cpuZonesMs\": ";
+        WriteZoneSummaries(file, summary.cpuZones);
+        file << ",\n";
+        file << "  \"gpuZonesMs\": ";
+        WriteZoneSummaries(file, summary.gpuZones);
+        file << ",\n";
+        file << "  \"pipelineStatistics\": {";
+        for (size_t i = 0; i < summary.pipelineStatistics.size(); i++)
+        {
+            auto& statistics = summary.pipelineStatistics[i];
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    \"" << statistics.name << "\": {\"samples\": " << statistics.sampleCount
+                << ", \"vertexShaderInvocations\": " << statistics.vertexShaderInvocations
+                << ", \"clippingInvocations\": " << statistics.clippingInvocations
+                << ", \"clippingPrimitives\": " << statistics.clippingPrimitives
+                << ", \"fragmentShaderInvocations\": " << statistics.fragmentShaderInvocations
+                << ", \"clippedRatio\": " << statistics.clippedRatio << "}";
+        }
+        file << (summary.pipelineStatistics.empty() ? "},\n" : "\n  },\n");
+        // Per-frame counters are in order: vertex shader invocations, clipping invocations,
+        // clipping primitives, fragment shader invocations.
+        file << "  \"frames\": [";
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    {\"frame\": " << frames[i].frame << ", \"cpuTimeMs\": " << frames[i].cpuTimeMs;
+            file << ", \"cpuZonesMs\": ";
+            WriteZones(file, frames[i].cpuZones);
+            file << ", \"gpuZonesMs\": ";
+            WriteZones(file, frames[i].gpuZones);
+            file << ", \"pipelineStatistics\": ";
+            WritePipelineStatistics(file, frames[i].pipelineStatistics);
+            file << "}";
+        }
+        file << "\n  ]\n";
+        file << "}\n";
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Collects per-frame timings and summarizes them, used by benchmark runs.
+    /// </summary>
+    class FrameStatistics
+    {
+    public:
+        /// <summary>
+        /// Time spent in named part of frame, e.g. single render system.
+        /// </summary>
+        struct ZoneSample
+        {
+            // Must outlive statistics, zones are named with string literals.
+            const char* name;
+            double timeMs;
+        };
+
+        /// <summary>
+        /// Shader work counted by GPU for named part of frame.
+        /// </summary>
+        struct PipelineStatisticsSample
+        {
+            const char* name;
+            uint64_t vertexShaderInvocations;
+            uint64_t clippingInvocations;
+            uint64_t clippingPrimitives;
+            uint64_t fragmentShaderInvocations;
+        };
+
+        /// <summary>
+        /// Data measured for single frame.
+        /// </summary>
+        struct FrameSample
+        {
+            uint32_t frame;
+            double cpuTimeMs;
+            std::vector<ZoneSample> cpuZones;
+            // GPU results arrive few frames later, empty if they never did.
+            std::vector<ZoneSample> gpuZones;
+            std::vector<PipelineStatisticsSample> pipelineStatistics;
+        };
+
+        /// <summary>
+        /// Aggregated times of single zone.
+        /// </summary>
+        struct ZoneSummary
+        {
+            std::string name;
+            size_t sampleCount = 0;
+            double averageMs = 0.0;
+            double p50Ms = 0.0;
+            double p95Ms = 0.0;
+            double maxMs = 0.0;
+        };
+
+        /// <summary>
+        /// Average pipeline statistics of single zone.
+        /// </summary>
+        struct PipelineStatisticsSummary
+        {
+            std::string name;
+            size_t sampleCount = 0;
+            double vertexShaderInvocations = 0.0;
+            double clippingInvocations = 0.0;
+            double clippingPrimitives = 0.0;
+            double fragmentShaderInvocations = 0.0;
+            // Part of primitives discarded by clipping, i.e. outside of view
+            double clippedRatio = 0.0;
+        };
+
+        /// <summary>
+        /// Aggregated timings of all recorded frames.
+        /// </summary>
+        struct Summary
+        {
+            size_t frameCount = 0;
+            double totalTimeSeconds = 0.0;
+            double framesPerSecond = 0.0;
+            double minMs = 0.0;
+            double averageMs = 0.0;
+            double p50Ms = 0.0;
+            double p95Ms = 0.0;
+            double p99Ms = 0.0;
+            double maxMs = 0.0;
+            std::vector<ZoneSummary> cpuZones;
+            std::vector<ZoneSummary> gpuZones;
+            std::vector<PipelineStatisticsSummary> pipelineStatistics;
+        };
+
+        /// <summary>
+        /// Create empty statistics.
+        /// </summary>
+        /// <param name="warmupFrames"> Number of first frames which are not recorded</param>
+        FrameStatistics(uint32_t warmupFrames = 0);
+
+        /// <summary>
+        /// Record time of next frame.
+        /// </summary>
+        /// <param name="cpuTimeMs"> Time spent on frame by CPU, in milliseconds</param>
+        /// <param name="cpuZones"> CPU times of frame parts</param>
+        void AddFrame(double cpuTimeMs, std::vector<ZoneSample> cpuZones = {});
+
+        /// <summary>
+        /// Attach GPU times to already recorded frame. Times of warmup frames are ignored.
+        /// </summary>
+        /// <param name="frame"> Number of frame, counted the same way as in AddFrame</param>
+        /// <param name="gpuZones"> GPU times of frame parts</param>
+        void AddGpuTimes(uint32_t frame, std::vector<ZoneSample> gpuZones);
+
+        /// <summary>
+        /// Attach pipeline statistics to already recorded frame. Statistics of warmup frames are ignored.
+        /// </summary>
+        /// <param name="frame"> Number of frame, counted the same way as in AddFrame</param>
+        /// <param name="pipelineStatistics"> Counters of frame parts</param>
+        void AddPipelineStatistics(uint32_t frame, std::vector<PipelineStatisticsSample> pipelineStatistics);
+
+        /// <summary>
+        /// Calculate percentiles and throughput of recorded frames.
+        /// </summary>
+        /// <returns> Summary of recorded frames</returns>
+        Summary Summarize() const;
+
+        /// <summary>
+        /// Write summary and all recorded frames to JSON file.
+        /// </summary>
+        /// <param name="filepath"> Path of output file</param>
+        void WriteJson(const std::string& filepath) const;
+
+        const std::vector<FrameSample>& GetFrames() const
+        {
+            return frames;
+        }
+
+    private:
+        /// <summary>
+        /// Summarize each zone name found in given zones of all frames, in order of first appearance.
+        /// </summary>
+        /// <param name="zonesOfFrame"> Selects CPU or GPU zones of frame</param>
+        /// <returns> Summary of each zone</returns>
+        std::vector<ZoneSummary> SummarizeZones(std::vector<ZoneSample> FrameSample::* zonesOfFrame) const;
+
+        /// <summary>
+        /// Average pipeline statistics of each zone name, in order of first appearance.
+        /// </summary>
+        /// <returns> Summary of each zone</returns>
+        std::vector<PipelineStatisticsSummary> SummarizePipelineStatistics() const;
+
+        /// <summary>
+        /// Find recorded frame by its number.
+        /// </summary>
+        /// <param name="frame"> Number of frame</param>
+        /// <returns> Recorded frame or nullptr if frame is warmup or was not recorded</returns>
+        FrameSample* FindFrame(uint32_t frame);
+
+        uint32_t warmupFrames;
+        uint32_t frameCounter = 0;
+        std::vector<FrameSample> frames;
+    };
+}
@@ -70,4 +70,23 @@ namespace VulkanEngine
         static id_t currentId = 0;
         return GameObject(currentId++);
     }
+
+    void GameObject::UpdateWorldBounds()
+    {
+        if (model.get() == boundsModel && transform == boundsTransform)
+        {
+            return;
+        }
+        boundsModel = model.get();
+        boundsTransform = transform;
+        if (model == nullptr)
+        {
+            worldBounds = {};
+            worldSphere = {};
+            return;
+        }
+        glm::mat4 matrix = transform.GetTransformationMatrix();
+        worldBounds = model->GetBounds().Transform(matrix);
+        worldSphere = model->GetBoundingSphere().Transform(matrix);
+    }
 }
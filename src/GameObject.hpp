@@ -27,6 +27,16 @@ namespace VulkanEngine
         /// </summary>
         /// <returns> glm::mat3 normal transformation</returns>
         glm::mat3 GetNormalTransformationMatrix();
+
+        bool operator==(const TransformComponent& other) const
+        {
+            return translation == other.translation && scale == other.scale && rotation == other.rotation;
+        }
+
+        bool operator!=(const TransformComponent& other) const
+        {
+            return !(*this == other);
+        }
     };
 
     class GameObject
@@ -51,12 +61,46 @@ namespace VulkanEngine
         glm::vec3 color{};
         TransformComponent transform{};
         VkDescriptorSet descriptorSet;
+        // Generation of texture written into descriptor set, texture gets new image when restored
+        uint32_t textureGeneration = UINT32_MAX;
+        // Level of detail drawn last frame, selection keeps it until error is clearly off
+        uint32_t lodLevel = 0;
+
+        /// <summary>
+        /// Bounding box of model in world space, empty without model. Recomputed only when transform
+        /// or model changed since last call.
+        /// </summary>
+        const BoundingBox& GetWorldBounds()
+        {
+            UpdateWorldBounds();
+            return worldBounds;
+        }
+
+        /// <summary>
+        /// Bounding sphere of model in world space, empty without model. Recomputed only when transform
+        /// or model changed since last call.
+        /// </summary>
+        const BoundingSphere& GetWorldSphere()
+        {
+            UpdateWorldBounds();
+            return worldSphere;
+        }
 
     private:
         GameObject(id_t id) : id(id)
         {
         }
 
+        /// <summary>
+        /// Transform model bounds to world space if transform or model changed.
+        /// </summary>
+        void UpdateWorldBounds();
+
         id_t id;
+        // Transform and model world bounds were computed for
+        TransformComponent boundsTransform{};
+        const Model* boundsModel = nullptr;
+        BoundingBox worldBounds{};
+        BoundingSphere worldSphere{};
     };
 }
@@ -0,0 +1,222 @@
+#include "GeometryPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <numeric>
+
+namespace VulkanEngine
+{
+    GeometryPool::GeometryPool(Device& device):
+        device(device)
+    {
+    }
+
+    bool GeometryPool::AllocateInPage(Page& page, uint32_t vertexCount, uint32_t indexCount, Allocation& allocation)
+    {
+        TlsfMetadata::Allocation vertices;
+        if (!page.vertices.Allocate(vertexCount, 1, vertices))
+        {
+            return false;
+        }
+
+        TlsfMetadata::Allocation indices;
+        if (indexCount > 0 && !page.indices.Allocate(indexCount, 1, indices))
+        {
+            page.vertices.Free(vertices.handle);
+            return false;
+        }
+
+        allocation.firstVertex = static_cast<uint32_t>(vertices.offset);
+        allocation.vertexCount = vertexCount;
+        allocation.vertexHandle = vertices.handle;
+        allocation.firstIndex = indexCount > 0 ? static_cast<uint32_t>(indices.offset) : 0;
+        allocation.indexCount = indexCount;
+        allocation.indexHandle = indexCount > 0 ? indices.handle : TlsfMetadata::INVALID_HANDLE;
+        page.liveAllocations++;
+        return true;
+    }
+
+    VkDeviceSize GeometryPool::GetPageBytes(const Page& page)
+    {
+        VkDeviceSize vertexSize = std::accumulate(page.vertexStrides.begin(), page.vertexStrides.end(),
+                                                  VkDeviceSize{0});
+        return page.vertices.GetSize() * vertexSize + page.indexBuffer->GetBufferSize();
+    }
+
+    uint32_t GeometryPool::CreatePage(const std::vector<VkDeviceSize>& vertexStrides, VkIndexType indexType,
+                                      uint32_t vertexCapacity, uint32_t indexCapacity)
+    {
+        auto page = std::make_unique<Page>(vertexStrides, indexType, vertexCapacity, indexCapacity);
+        for (VkDeviceSize stride : vertexStrides)
+        {
+            page->vertexBuffers.push_back(std::make_unique<Buffer>(
+                device,
+                stride,
+                vertexCapacity,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        }
+        page->indexBuffer = std::make_unique<Buffer>(
+            device,
+            GetIndexSize(indexType),
+            indexCapacity,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        auto slot = std::find(pages.begin(), pages.end(), nullptr);
+        if (slot == pages.end())
+        {
+            pages.push_back(std::move(page));
+            return static_cast<uint32_t>(pages.size() - 1);
+        }
+        *slot = std::move(page);
+        return static_cast<uint32_t>(slot - pages.begin());
+    }
+
+    GeometryPool::Allocation GeometryPool::Allocate(const std::vector<VkDeviceSize>& vertexStrides,
+                                                    uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        Allocation allocation{};
+        for (uint32_t i = 0; i < pages.size(); i++)
+        {
+            // Page with only retired allocations is waiting to be released
+            if (pages[i] != nullptr && pages[i]->liveAllocations > 0 && pages[i]->vertexStrides == vertexStrides &&
+                pages[i]->indexType == indexType && AllocateInPage(*pages[i], vertexCount, indexCount, allocation))
+            {
+                allocation.page = i;
+                return allocation;
+            }
+        }
+
+        // Geometry which doesn't fit into standard page gets its own
+        VkDeviceSize vertexSize = std::accumulate(vertexStrides.begin(), vertexStrides.end(), VkDeviceSize{0});
+        auto vertexCapacity = static_cast<uint32_t>(std::max<VkDeviceSize>(VERTEX_PAGE_SIZE / vertexSize, vertexCount));
+        auto indexCapacity = static_cast<uint32_t>(std::max<VkDeviceSize>(INDEX_PAGE_SIZE / GetIndexSize(indexType), indexCount));
+        uint32_t page = CreatePage(vertexStrides, indexType, vertexCapacity, indexCapacity);
+        AllocateInPage(*pages[page], vertexCount, indexCount, allocation);
+        allocation.page = page;
+        return allocation;
+    }
+
+    VkDeviceSize GeometryPool::Retire(const Allocation& allocation)
+    {
+        if (!allocation.IsValid())
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        Page& page = *pages[allocation.page];
+        assert(page.liveAllocations > 0);
+        page.liveAllocations--;
+        return page.liveAllocations == 0 ? GetPageBytes(page) : 0;
+    }
+
+    void GeometryPool::Free(Allocation& allocation)
+    {
+        if (!allocation.IsValid())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        auto& page = pages[allocation.page];
+        page->vertices.Free(allocation.vertexHandle);
+        if (allocation.indexHandle != TlsfMetadata::INVALID_HANDLE)
+        {
+            page->indices.Free(allocation.indexHandle);
+        }
+        // Buffers are destroyed by deletion queue, allocations were freed only after frames stopped using them
+        if (page->vertices.IsEmpty())
+        {
+            page.reset();
+        }
+        allocation = {};
+    }
+
+    UploadToken GeometryPool::Upload(const Allocation& allocation, const std::vector<const void*>& vertexStreams,
+                                     const void* indices)
+    {
+        std::vector<VkBuffer> vertexBuffers;
+        std::vector<VkDeviceSize> vertexStrides;
+        VkBuffer indexBuffer;
+        VkDeviceSize indexSize;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            const auto& page = *pages[allocation.page];
+            for (const auto& buffer : page.vertexBuffers)
+            {
+                vertexBuffers.push_back(buffer->GetBuffer());
+            }
+            vertexStrides = page.vertexStrides;
+            indexBuffer = page.indexBuffer->GetBuffer();
+            indexSize = GetIndexSize(page.indexType);
+        }
+        assert(vertexStreams.size() == vertexBuffers.size());
+
+        UploadContext& uploadContext = device.GetUploadContext();
+        UploadToken token = 0;
+        for (size_t i = 0; i < vertexBuffers.size(); i++)
+        {
+            token = uploadContext.UploadBuffer(vertexStreams[i], allocation.vertexCount * vertexStrides[i],
+                                               vertexBuffers[i], allocation.firstVertex * vertexStrides[i]);
+        }
+        if (allocation.indexCount > 0)
+        {
+            token = uploadContext.UploadBuffer(indices, allocation.indexCount * indexSize, indexBuffer,
+                                               allocation.firstIndex * indexSize);
+        }
+        return token;
+    }
+
+    void GeometryPool::Bind(VkCommandBuffer commandBuffer, uint32_t page, uint32_t streamCount) const
+    {
+        std::array<VkBuffer, MAX_VERTEX_STREAMS> vertexBuffers{};
+        VkBuffer indexBuffer;
+        VkIndexType indexType;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            streamCount = std::min(streamCount, static_cast<uint32_t>(pages[page]->vertexBuffers.size()));
+            for (uint32_t i = 0; i < streamCount; i++)
+            {
+                vertexBuffers[i] = pages[page]->vertexBuffers[i]->GetBuffer();
+            }
+            indexBuffer = pages[page]->indexBuffer->GetBuffer();
+            indexType = pages[page]->indexType;
+        }
+
+        std::array<VkDeviceSize, MAX_VERTEX_STREAMS> offsets{};
+        vkCmdBindVertexBuffers(commandBuffer, 0, streamCount, vertexBuffers.data(), offsets.data());
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+    }
+
+    uint32_t GeometryPool::GetLiveAllocationCount(uint32_t page) const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return pages[page]->liveAllocations;
+    }
+
+    GeometryPool::Statistics GeometryPool::GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        Statistics statistics{};
+        for (const auto& page : pages)
+        {
+            if (page == nullptr)
+            {
+                continue;
+            }
+            auto vertices = page->vertices.GetStatistics();
+            auto indices = page->indices.GetStatistics();
+            statistics.pageCount++;
+            statistics.allocationCount += vertices.allocationCount;
+            VkDeviceSize vertexSize = std::accumulate(page->vertexStrides.begin(), page->vertexStrides.end(),
+                                                      VkDeviceSize{0});
+            statistics.pageBytes += GetPageBytes(*page);
+            statistics.usedBytes += vertices.usedBytes * vertexSize + indices.usedBytes * GetIndexSize(page->indexType);
+        }
+        return statistics;
+    }
+}
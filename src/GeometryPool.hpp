@@ -0,0 +1,171 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "TlsfMetadata.hpp"
+#include "UploadContext.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Vertices and indices of all models sub-allocated from few large device local buffers. Page is index
+    /// buffer and vertex buffer for each vertex stream, models of one page are drawn with single bind using
+    /// first index and vertex offset. Each page holds vertices of one layout (strides of streams), so vertex
+    /// offset is in whole vertices and same for all streams, and indices of one type.
+    /// </summary>
+    class GeometryPool
+    {
+    public:
+        static constexpr VkDeviceSize VERTEX_PAGE_SIZE = 32ull * 1024 * 1024;
+        static constexpr VkDeviceSize INDEX_PAGE_SIZE = 16ull * 1024 * 1024;
+        static constexpr uint32_t INVALID_PAGE = ~0u;
+        static constexpr uint32_t MAX_VERTEX_STREAMS = 2;
+
+        /// <summary>
+        /// Range of model in page.
+        /// </summary>
+        struct Allocation
+        {
+            uint32_t page = INVALID_PAGE;
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+
+            // Used by pool only
+            uint32_t vertexHandle = TlsfMetadata::INVALID_HANDLE;
+            uint32_t indexHandle = TlsfMetadata::INVALID_HANDLE;
+
+            bool IsValid() const
+            {
+                return page != INVALID_PAGE;
+            }
+        };
+
+        struct Statistics
+        {
+            uint32_t pageCount = 0;
+            uint32_t allocationCount = 0;
+            VkDeviceSize pageBytes = 0;
+            VkDeviceSize usedBytes = 0;
+        };
+
+        /// <summary>
+        /// Create pool without pages.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        GeometryPool(Device& device);
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        /// <summary>
+        /// Allocate vertices and indices in one page, new page is created if none has space.
+        /// Geometry bigger than page gets its own page of exact size.
+        /// </summary>
+        /// <param name="vertexStrides"> Size of one vertex in each stream, bound to consecutive bindings</param>
+        /// <param name="vertexCount"> Number of vertices</param>
+        /// <param name="indexCount"> Number of indices, can be 0</param>
+        /// <param name="indexType"> VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32</param>
+        /// <returns> Allocated ranges</returns>
+        /// <exception cref="OutOfMemoryError"> Device memory is exhausted</exception>
+        Allocation Allocate(const std::vector<VkDeviceSize>& vertexStrides, uint32_t vertexCount, uint32_t indexCount,
+                            VkIndexType indexType);
+
+        /// <summary>
+        /// Mark allocation as going to be freed once frames in flight stop using it. Page without other
+        /// allocations gets no new ones, so it is released by Free of its last allocation.
+        /// </summary>
+        /// <param name="allocation"> Allocation which will be freed</param>
+        /// <returns> Bytes of page if it will be released, 0 if other allocations keep it</returns>
+        VkDeviceSize Retire(const Allocation& allocation);
+
+        /// <summary>
+        /// Return ranges to page immediately, caller makes sure no frame in flight uses them.
+        /// Empty pages are released.
+        /// </summary>
+        /// <param name="allocation"> Allocation to free, reset to empty state</param>
+        void Free(Allocation& allocation);
+
+        /// <summary>
+        /// Record upload of geometry into its ranges.
+        /// </summary>
+        /// <param name="allocation"> Allocated ranges</param>
+        /// <param name="vertexStreams"> Data of allocation.vertexCount vertices for each stream</param>
+        /// <param name="indices"> Index data of allocation.indexCount indices of page index type, may be null without
+        /// indices</param>
+        /// <returns> Token of upload</returns>
+        UploadToken Upload(const Allocation& allocation, const std::vector<const void*>& vertexStreams,
+                           const void* indices);
+
+        /// <summary>
+        /// Bind vertex buffers and index buffer of page.
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="page"> Page of allocations to be drawn</param>
+        /// <param name="streamCount"> Number of streams bound from binding 0, depth passes bind positions only</param>
+        void Bind(VkCommandBuffer commandBuffer, uint32_t page, uint32_t streamCount = UINT32_MAX) const;
+
+        /// <summary>
+        /// Number of allocations in page which are not retired, page is released only when it reaches 0.
+        /// </summary>
+        uint32_t GetLiveAllocationCount(uint32_t page) const;
+
+        Statistics GetStatistics() const;
+
+        static VkDeviceSize GetIndexSize(VkIndexType indexType)
+        {
+            return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        }
+
+    private:
+        struct Page
+        {
+            std::vector<VkDeviceSize> vertexStrides;
+            std::vector<std::unique_ptr<Buffer>> vertexBuffers;
+            VkIndexType indexType;
+            std::unique_ptr<Buffer> indexBuffer;
+            // Offsets in vertices
+            TlsfMetadata vertices;
+            // Offsets in indices
+            TlsfMetadata indices;
+            // Allocations which are not retired
+            uint32_t liveAllocations = 0;
+
+            Page(const std::vector<VkDeviceSize>& vertexStrides, VkIndexType indexType, uint32_t vertexCapacity,
+                 uint32_t indexCapacity):
+                vertexStrides(vertexStrides),
+                indexType(indexType),
+                vertices(vertexCapacity),
+                indices(indexCapacity)
+            {
+            }
+        };
+
+        /// <summary>
+        /// Allocate ranges in page, nothing is allocated if one of them doesn't fit.
+        /// </summary>
+        static bool AllocateInPage(Page& page, uint32_t vertexCount, uint32_t indexCount, Allocation& allocation);
+
+        /// <summary>
+        /// Device memory of page buffers.
+        /// </summary>
+        static VkDeviceSize GetPageBytes(const Page& page);
+
+        /// <summary>
+        /// Create buffers of new page and store it into free slot.
+        /// </summary>
+        /// <returns> Index of page</returns>
+        uint32_t CreatePage(const std::vector<VkDeviceSize>& vertexStrides, VkIndexType indexType,
+                            uint32_t vertexCapacity, uint32_t indexCapacity);
+
+        Device& device;
+
+        mutable std::mutex mutex;
+        // Released pages leave empty slot, so page index of allocations stays valid
+        std::vector<std::unique_ptr<Page>> pages;
+    };
+}
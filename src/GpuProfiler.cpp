@@ -0,0 +1,251 @@
+#include "GpuProfiler.hpp"
+
+#include <stdexcept>
+
+namespace VulkanEngine
+{
+    // Counters are returned in order of their bits.
+    static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    static constexpr uint32_t PIPELINE_STATISTICS_COUNT = 4;
+
+    GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight):
+        device(device),
+        frames(framesInFlight)
+    {
+        uint32_t validBits = device.GetQueueFamilyProperties(
+            device.FindPhysicalQueueFamilies().graphicsFamily).timestampValidBits;
+        supported = validBits > 0 && device.properties.limits.timestampPeriod > 0.f;
+        statisticsSupported = device.enabledFeatures.pipelineStatisticsQuery == VK_TRUE;
+
+        timestampPeriod = device.properties.limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = MAX_ZONES * 2;
+
+        VkQueryPoolCreateInfo statisticsPoolInfo{};
+        statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsPoolInfo.queryCount = MAX_ZONES;
+        statisticsPoolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+
+        for (auto& frame : frames)
+        {
+            if (supported &&
+                vkCreateQueryPool(device.GetDevice(), &queryPoolInfo, nullptr, &frame.queryPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create query pool!");
+            }
+            if (statisticsSupported &&
+                vkCreateQueryPool(device.GetDevice(), &statisticsPoolInfo, nullptr, &frame.statisticsPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline statistics query pool!");
+            }
+            frame.zoneNames.reserve(MAX_ZONES);
+            frame.statisticsNames.reserve(MAX_ZONES);
+        }
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        for (auto& frame : frames)
+        {
+            if (frame.queryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(device.GetDevice(), frame.queryPool, nullptr);
+            }
+            if (frame.statisticsPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(device.GetDevice(), frame.statisticsPool, nullptr);
+            }
+        }
+    }
+
+    void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, int frameIndex, uint32_t frameNumber)
+    {
+        if (!supported && !statisticsSupported)
+        {
+            return;
+        }
+
+        // Fence of this frame was already waited, so results are ready unless frames got out of sync.
+        currentFrame = &frames[frameIndex];
+        if (currentFrame->pending)
+        {
+            ReadResults(*currentFrame);
+        }
+
+        if (supported)
+        {
+            vkCmdResetQueryPool(commandBuffer, currentFrame->queryPool, 0, MAX_ZONES * 2);
+        }
+        if (statisticsSupported)
+        {
+            vkCmdResetQueryPool(commandBuffer, currentFrame->statisticsPool, 0, MAX_ZONES);
+        }
+        currentFrame->zoneNames.clear();
+        currentFrame->statisticsNames.clear();
+        currentFrame->frameNumber = frameNumber;
+        currentFrame->pending = true;
+    }
+
+    uint32_t GpuProfiler::BeginZone(VkCommandBuffer commandBuffer, const char* name)
+    {
+        if (!supported || currentFrame == nullptr || currentFrame->zoneNames.size() >= MAX_ZONES)
+        {
+            return INVALID_ZONE;
+        }
+
+        auto zone = static_cast<uint32_t>(currentFrame->zoneNames.size());
+        currentFrame->zoneNames.push_back(name);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentFrame->queryPool, zone * 2);
+        return zone;
+    }
+
+    void GpuProfiler::EndZone(VkCommandBuffer commandBuffer, uint32_t zone)
+    {
+        if (zone == INVALID_ZONE)
+        {
+            return;
+        }
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentFrame->queryPool,
+                            zone * 2 + 1);
+    }
+
+    uint32_t GpuProfiler::BeginStatistics(VkCommandBuffer commandBuffer, const char* name)
+    {
+        if (!statisticsSupported || currentFrame == nullptr || currentFrame->statisticsNames.size() >= MAX_ZONES)
+        {
+            return INVALID_ZONE;
+        }
+
+        auto query = static_cast<uint32_t>(currentFrame->statisticsNames.size());
+        currentFrame->statisticsNames.push_back(name);
+        vkCmdBeginQuery(commandBuffer, currentFrame->statisticsPool, query, 0);
+        return query;
+    }
+
+    void GpuProfiler::EndStatistics(VkCommandBuffer commandBuffer, uint32_t query)
+    {
+        if (query == INVALID_ZONE)
+        {
+            return;
+        }
+        vkCmdEndQuery(commandBuffer, currentFrame->statisticsPool, query);
+    }
+
+    void GpuProfiler::CollectPending()
+    {
+        for (auto& frame : frames)
+        {
+            if (frame.pending)
+            {
+                ReadResults(frame);
+            }
+        }
+    }
+
+    std::vector<GpuProfiler::FrameResult> GpuProfiler::TakeResults()
+    {
+        std::vector<FrameResult> taken;
+        taken.swap(results);
+        return taken;
+    }
+
+    void GpuProfiler::ReadResults(FrameQueries& frame)
+    {
+        frame.pending = false;
+        if (frame.zoneNames.empty() && frame.statisticsNames.empty())
+        {
+            return;
+        }
+
+        FrameResult frameResult{frame.frameNumber, {}, {}};
+        ReadTimestamps(frame, frameResult);
+        ReadStatistics(frame, frameResult);
+        results.push_back(std::move(frameResult));
+    }
+
+    void GpuProfiler::ReadTimestamps(const FrameQueries& frame, FrameResult& frameResult)
+    {
+        auto queryCount = static_cast<uint32_t>(frame.zoneNames.size() * 2);
+        if (queryCount == 0)
+        {
+            return;
+        }
+
+        // Each query gives its value followed by availability, so nothing waits for GPU.
+        std::vector<uint64_t> data(static_cast<size_t>(queryCount) * 2);
+        VkResult result = vkGetQueryPoolResults(
+            device.GetDevice(),
+            frame.queryPool,
+            0,
+            queryCount,
+            data.size() * sizeof(uint64_t),
+            data.data(),
+            2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+        {
+            return;
+        }
+
+        for (uint32_t zone = 0; zone < frame.zoneNames.size(); zone++)
+        {
+            uint64_t begin = data[zone * 4];
+            uint64_t beginAvailable = data[zone * 4 + 1];
+            uint64_t end = data[zone * 4 + 2];
+            uint64_t endAvailable = data[zone * 4 + 3];
+            if (!beginAvailable || !endAvailable)
+            {
+                continue;
+            }
+
+            uint64_t ticks = (end - begin) & timestampMask;
+            frameResult.zones.push_back({frame.zoneNames[zone], static_cast<double>(ticks) * timestampPeriod / 1e6});
+        }
+    }
+
+    void GpuProfiler::ReadStatistics(const FrameQueries& frame, FrameResult& frameResult)
+    {
+        auto queryCount = static_cast<uint32_t>(frame.statisticsNames.size());
+        if (queryCount == 0)
+        {
+            return;
+        }
+
+        // Counters of each query are followed by its availability.
+        constexpr uint32_t stride = PIPELINE_STATISTICS_COUNT + 1;
+        std::vector<uint64_t> data(static_cast<size_t>(queryCount) * stride);
+        VkResult result = vkGetQueryPoolResults(
+            device.GetDevice(),
+            frame.statisticsPool,
+            0,
+            queryCount,
+            data.size() * sizeof(uint64_t),
+            data.data(),
+            stride * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+        {
+            return;
+        }
+
+        for (uint32_t query = 0; query < queryCount; query++)
+        {
+            const uint64_t* counters = &data[query * stride];
+            if (!counters[PIPELINE_STATISTICS_COUNT])
+            {
+                continue;
+            }
+            frameResult.statistics.push_back({
+                frame.statisticsNames[query], counters[0], counters[1], counters[2], counters[3]});
+        }
+    }
+}
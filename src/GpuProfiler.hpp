@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+
+#include "Device.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Measures GPU time of command buffer parts with timestamp queries and counts shader work
+    /// with pipeline statistics queries. Each frame in flight has its own query pools, results are
+    /// read without waiting when the pools are reused, i.e. when GPU finished that frame.
+    /// </summary>
+    class GpuProfiler
+    {
+    public:
+        static constexpr uint32_t MAX_ZONES = 32;
+        static constexpr uint32_t INVALID_ZONE = ~0u;
+
+        /// <summary>
+        /// GPU time of single zone.
+        /// </summary>
+        struct ZoneResult
+        {
+            const char* name;
+            double timeMs;
+        };
+
+        /// <summary>
+        /// Pipeline statistics counted for single zone.
+        /// </summary>
+        struct StatisticsResult
+        {
+            const char* name;
+            uint64_t vertexShaderInvocations;
+            // Primitives entering clipping stage
+            uint64_t clippingInvocations;
+            // Primitives which survived clipping, the rest was outside view
+            uint64_t clippingPrimitives;
+            uint64_t fragmentShaderInvocations;
+        };
+
+        /// <summary>
+        /// All zones measured in one frame.
+        /// </summary>
+        struct FrameResult
+        {
+            uint32_t frameNumber;
+            std::vector<ZoneResult> zones;
+            std::vector<StatisticsResult> statistics;
+        };
+
+        /// <summary>
+        /// Create query pool for each frame in flight.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="framesInFlight"> Number of frames recorded in parallel</param>
+        GpuProfiler(Device& device, uint32_t framesInFlight);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        /// <summary>
+        /// Start new frame. Collects results of previous frame which used the same pool and resets it.
+        /// Must be recorded outside of render pass.
+        /// </summary>
+        /// <param name="commandBuffer"> Command buffer of new frame</param>
+        /// <param name="frameIndex"> Index of frame in flight</param>
+        /// <param name="frameNumber"> Number of frame since start, reported with results</param>
+        void BeginFrame(VkCommandBuffer commandBuffer, int frameIndex, uint32_t frameNumber);
+
+        /// <summary>
+        /// Write timestamp starting zone.
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="name"> Zone name, must outlive profiler (string literal)</param>
+        /// <returns> Zone to be passed to EndZone, INVALID_ZONE if zone can't be measured</returns>
+        uint32_t BeginZone(VkCommandBuffer commandBuffer, const char* name);
+
+        /// <summary>
+        /// Write timestamp ending zone.
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="zone"> Zone returned by BeginZone</param>
+        void EndZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+        /// <summary>
+        /// Begin pipeline statistics query. Queries can't be nested, so begin and end
+        /// must be recorded around single pass part, e.g. one render system, in the same subpass.
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="name"> Zone name, must outlive profiler (string literal)</param>
+        /// <returns> Query to be passed to EndStatistics, INVALID_ZONE if statistics are not supported</returns>
+        uint32_t BeginStatistics(VkCommandBuffer commandBuffer, const char* name);
+
+        /// <summary>
+        /// End pipeline statistics query.
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="query"> Query returned by BeginStatistics</param>
+        void EndStatistics(VkCommandBuffer commandBuffer, uint32_t query);
+
+        /// <summary>
+        /// Read results of all frames, which are not collected yet. Frames not finished by GPU are skipped.
+        /// Useful after vkDeviceWaitIdle to get last frames.
+        /// </summary>
+        void CollectPending();
+
+        /// <summary>
+        /// Get collected results and remove them from profiler.
+        /// </summary>
+        /// <returns> Results of frames finished since last call</returns>
+        std::vector<FrameResult> TakeResults();
+
+        bool IsSupported() const
+        {
+            return supported;
+        }
+
+        bool IsStatisticsSupported() const
+        {
+            return statisticsSupported;
+        }
+
+    private:
+        struct FrameQueries
+        {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            VkQueryPool statisticsPool = VK_NULL_HANDLE;
+            std::vector<const char*> zoneNames;
+            std::vector<const char*> statisticsNames;
+            uint32_t frameNumber = 0;
+            bool pending = false;
+        };
+
+        /// <summary>
+        /// Read results of frame queries without waiting. Zones not yet available are dropped.
+        /// </summary>
+        /// <param name="frame"> Frame to read</param>
+        void ReadResults(FrameQueries& frame);
+        void ReadTimestamps(const FrameQueries& frame, FrameResult& frameResult);
+        void ReadStatistics(const FrameQueries& frame, FrameResult& frameResult);
+
+        Device& device;
+        bool supported = false;
+        bool statisticsSupported = false;
+        double timestampPeriod = 1.0;
+        uint64_t timestampMask = ~0ull;
+
+        std::vector<FrameQueries> frames;
+        FrameQueries* currentFrame = nullptr;
+        std::vector<FrameResult> results;
+    };
+}
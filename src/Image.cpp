@@ -3,19 +3,32 @@
 #include <stb_image.h>
 #include "Image.hpp"
 
+#include <iostream>
 #include <stdexcept>
 
 #include "Buffer.hpp"
 #include "Device.hpp"
+#include "Profiler.hpp"
+#include "UploadContext.hpp"
 
 namespace VulkanEngine
 {
     Image::Image(Device& device, VkImageCreateInfo imageInfo, VkMemoryPropertyFlagBits memoryProperties,
                  VkImageSubresourceRange subresourceRange, VkSamplerCreateInfo samplerInfo)
-        : device(device)
+        : Image(device, imageInfo, memoryProperties, subresourceRange, samplerInfo, std::string{})
+    {
+        CreateImage();
+    }
+
+    Image::Image(Device& device, const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags memoryProperties,
+                 VkImageSubresourceRange subresourceRange, const VkSamplerCreateInfo& samplerInfo,
+                 std::string sourcePath)
+        : device(device),
+          imageInfo(imageInfo),
+          memoryProperties(memoryProperties),
+          subresourceRange(subresourceRange),
+          sourcePath(std::move(sourcePath))
     {
-        device.CreateImageWithInfo(imageInfo, memoryProperties, image, imageMemory);
-        device.CreateImageView(image, imageInfo.format, imageView, subresourceRange);
         if (vkCreateSampler(device.GetDevice(), &samplerInfo, nullptr, &imageSampler) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create sampler!");
@@ -24,45 +37,103 @@ namespace VulkanEngine
 
     Image::~Image()
     {
-        vkDestroySampler(device.GetDevice(), imageSampler, nullptr);
-        vkDestroyImageView(device.GetDevice(), imageView, nullptr);
-        vkDestroyImage(device.GetDevice(), image, nullptr);
-        vkFreeMemory(device.GetDevice(), imageMemory, nullptr);
+        Evict();
+        device.GetDeletionQueue().Push([device = device.GetDevice(), imageSampler = imageSampler]()
+        {
+            vkDestroySampler(device, imageSampler, nullptr);
+        });
     }
 
-    std::unique_ptr<Image> Image::LoadImageFromFile(const std::string& filepath, Device& device)
+    void Image::CreateImage()
     {
-        int width, height, texChannels;
-        stbi_uc* pixels = stbi_load(filepath.c_str(), &width, &height, &texChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = width * height * 4;
+        device.CreateImageWithInfo(imageInfo, memoryProperties, image, imageMemory);
+        memorySize = imageMemory.size;
+        device.CreateImageView(image, imageInfo.format, imageView, subresourceRange);
+    }
 
+    VkDeviceSize Image::Evict()
+    {
+        if (!IsResident())
+        {
+            return 0;
+        }
+        // Frames in flight may still sample image
+        device.GetDeletionQueue().Push(
+            [device = &device, image = image, imageView = imageView, imageMemory = imageMemory]() mutable
+            {
+                vkDestroyImageView(device->GetDevice(), imageView, nullptr);
+                vkDestroyImage(device->GetDevice(), image, nullptr);
+                device->FreeMemory(imageMemory);
+            });
+        image = VK_NULL_HANDLE;
+        imageView = VK_NULL_HANDLE;
+        imageMemory = MemoryAllocation{};
+        return memorySize;
+    }
+
+    void Image::LoadFromSource()
+    {
+        int width, height, texChannels;
+        std::unique_ptr<stbi_uc, void (*)(void*)> pixels{
+            stbi_load(sourcePath.c_str(), &width, &height, &texChannels, STBI_rgb_alpha), stbi_image_free};
         if (!pixels)
         {
             throw std::runtime_error("failed to load texture image!");
         }
+        if (static_cast<uint32_t>(width) != imageInfo.extent.width ||
+            static_cast<uint32_t>(height) != imageInfo.extent.height)
+        {
+            throw std::runtime_error("texture image changed size!");
+        }
 
-        Buffer stagingBuffer(
-            device,
-            imageSize,
-            1,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        try
+        {
+            CreateImage();
+            // Transitions and copy are recorded to upload batch, image can be used after batch is submitted.
+            uploadToken = device.GetUploadContext().UploadImage(
+                pixels.get(), static_cast<VkDeviceSize>(width) * height * 4, image, imageInfo.format,
+                static_cast<uint32_t>(width), static_cast<uint32_t>(height), subresourceRange);
+        }
+        catch (const OutOfMemoryError&)
+        {
+            Evict();
+            throw;
+        }
+    }
 
-        stagingBuffer.Map();
-        stagingBuffer.WriteToBuffer(pixels, imageSize);
-        stbi_image_free(pixels);
+    void Image::Restore()
+    {
+        PROFILE_SCOPE("Image::Restore");
+        LoadFromSource();
+        generation++;
+    }
+
+    std::unique_ptr<Image> Image::LoadImageFromFile(const std::string& filepath, Device& device)
+    {
+        PROFILE_SCOPE("Image::LoadImageFromFile");
+        int width, height, texChannels;
+        if (!stbi_info(filepath.c_str(), &width, &height, &texChannels))
+        {
+            throw std::runtime_error("failed to load texture image!");
+        }
 
         VkImageCreateInfo imageInfo = {};
         DefaultImageCreateInfo(imageInfo, width, height, VK_FORMAT_R8G8B8A8_SRGB,
                                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
         VkSamplerCreateInfo samplerInfo = {};
         DefaultSamplerCreateInfo(samplerInfo, device);
-        auto image = std::make_unique<Image>(device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,Device::defaultSubresourceRange, samplerInfo);
-        device.TransitionImageLayout(image->GetImage(), VK_IMAGE_LAYOUT_UNDEFINED,
-                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, Device::defaultSubresourceRange);
-        device.CopyBufferToImage(stagingBuffer.GetBuffer(), image->GetImage(), width, height, 1);
-        device.TransitionImageLayout(image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, Device::defaultSubresourceRange);
+        std::unique_ptr<Image> image{new Image(device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               Device::defaultSubresourceRange, samplerInfo, filepath)};
+        try
+        {
+            image->LoadFromSource();
+        }
+        catch (const OutOfMemoryError&)
+        {
+            // Residency manager restores it once memory is available.
+            std::cerr << "out of device memory, texture " << filepath << " is loaded evicted" << std::endl;
+            image->memorySize = static_cast<VkDeviceSize>(width) * height * 4;
+        }
         return image;
     }
 
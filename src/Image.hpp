@@ -3,11 +3,12 @@
 #include <string>
 
 #include "Device.hpp"
+#include "EvictableResource.hpp"
 
 
 namespace VulkanEngine
 {
-    class Image
+    class Image : public EvictableResource
     {
     public:
         Image(Device& device, VkImageCreateInfo imageInfo, VkMemoryPropertyFlagBits memoryProperties,
@@ -16,6 +17,10 @@ namespace VulkanEngine
         Image(const Image&) = delete;
         Image& operator=(const Image&) = delete;
 
+        /// <summary>
+        /// Load texture from file. Image remembers file, so it can be evicted. If device memory is exhausted,
+        /// image is created evicted. Each call loads file again, AssetRegistry::LoadTexture shares loaded textures.
+        /// </summary>
         static std::unique_ptr<Image> LoadImageFromFile(const std::string& filepath, Device& device);
         static void DefaultImageCreateInfo(VkImageCreateInfo& imageInfo, int imageWidth, int imageHeight,
                                            VkFormat format, VkImageUsageFlags usage);
@@ -32,11 +37,68 @@ namespace VulkanEngine
         }
 
         VkDescriptorImageInfo GetDescriptorInfo(VkImageLayout currentLayout);
+
+        /// <summary>
+        /// Incremented when image is restored, descriptors written with older generation must be updated.
+        /// </summary>
+        uint32_t GetGeneration() const
+        {
+            return generation;
+        }
+
+        bool CanEvict() const override
+        {
+            return !sourcePath.empty();
+        }
+
+        bool IsResident() const override
+        {
+            return image != VK_NULL_HANDLE;
+        }
+
+        VkDeviceSize Evict() override;
+        void Restore() override;
+
+        VkDeviceSize GetMemorySize() const override
+        {
+            return memorySize;
+        }
+
+        UploadToken GetUploadToken() const override
+        {
+            return uploadToken;
+        }
+
     private:
+        /// <summary>
+        /// Create only sampler, image is created later.
+        /// </summary>
+        Image(Device& device, const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags memoryProperties,
+              VkImageSubresourceRange subresourceRange, const VkSamplerCreateInfo& samplerInfo, std::string sourcePath);
+
+        /// <summary>
+        /// Create image, its memory and view.
+        /// </summary>
+        void CreateImage();
+
+        /// <summary>
+        /// Create image and record upload of pixels loaded from source file.
+        /// </summary>
+        void LoadFromSource();
+
         Device& device;
+        VkImageCreateInfo imageInfo;
+        VkMemoryPropertyFlags memoryProperties;
+        VkImageSubresourceRange subresourceRange;
+        // File image was loaded from, empty if image was created empty
+        std::string sourcePath;
+        UploadToken uploadToken = 0;
+        uint32_t generation = 0;
+        VkDeviceSize memorySize = 0;
+
         VkImage image = VK_NULL_HANDLE;
         VkImageView imageView = VK_NULL_HANDLE;
-        VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+        MemoryAllocation imageMemory;
         VkSampler imageSampler = VK_NULL_HANDLE;
     };
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Read only memory mapping of whole file, unmapped on destruction. Empty file has null data.
+    /// </summary>
+    class MappedFile
+    {
+    public:
+        /// <summary>
+        /// Map file.
+        /// </summary>
+        /// <param name="filepath"> Path to file</param>
+        /// <exception cref="std::runtime_error"> File can't be opened or mapped</exception>
+        MappedFile(const std::string& filepath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* GetData() const
+        {
+            return data;
+        }
+
+        size_t GetSize() const
+        {
+            return size;
+        }
+
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        // File and mapping HANDLEs, windows.h stays out of header
+        void* file = nullptr;
+        void* mapping = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,258 @@
+#include "MemoryAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace VulkanEngine
+{
+    static VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return value / alignment * alignment;
+    }
+
+    static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, MemoryTracker& memoryTracker):
+        device(device),
+        memoryTracker(memoryTracker)
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto& block : blocks)
+        {
+            FreeDeviceMemory(block->memory, block->memoryType, block->metadata.GetSize());
+        }
+    }
+
+    VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryType) const
+    {
+        // Small heaps, e.g. device local host visible on some GPUs, would be used up by few blocks.
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        return std::min(PREFERRED_BLOCK_SIZE, AlignUp(heapSize / 8, 1024));
+    }
+
+    VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, void** mapped)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory;
+        VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+        if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY)
+        {
+            throw OutOfMemoryError("out of device memory!");
+        }
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+
+        *mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+
+        memoryTracker.OnDeviceMemoryAllocate(memoryType, size);
+        return memory;
+    }
+
+    void MemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size)
+    {
+        // Memory is unmapped implicitly when freed
+        vkFreeMemory(device, memory, nullptr);
+        memoryTracker.OnDeviceMemoryFree(memoryType, size);
+    }
+
+    MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType,
+                                               MemoryCategory category, bool linear)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        MemoryAllocation allocation{};
+        allocation.memoryType = memoryType;
+        allocation.size = requirements.size;
+        allocation.id = nextAllocationId++;
+
+        VkDeviceSize blockSize = GetBlockSize(memoryType);
+        if (requirements.size > blockSize / 2)
+        {
+            // Big resource would waste most of block, so it gets its own memory.
+            allocation.memory = AllocateDeviceMemory(memoryType, requirements.size, &allocation.mapped);
+            dedicatedAllocationCount++;
+            dedicatedBytes += requirements.size;
+            memoryTracker.OnAllocate(allocation.id, category, allocation.size);
+            return allocation;
+        }
+
+        TlsfMetadata::Allocation region{};
+        MemoryBlock* target = nullptr;
+        for (auto& block : blocks)
+        {
+            if (block->memoryType == memoryType && block->linear == linear &&
+                block->metadata.Allocate(requirements.size, requirements.alignment, region))
+            {
+                target = block.get();
+                break;
+            }
+        }
+
+        if (target == nullptr)
+        {
+            auto block = std::make_unique<MemoryBlock>(blockSize);
+            block->memoryType = memoryType;
+            block->linear = linear;
+            block->memory = AllocateDeviceMemory(memoryType, blockSize, &block->mapped);
+            if (!block->metadata.Allocate(requirements.size, requirements.alignment, region))
+            {
+                FreeDeviceMemory(block->memory, memoryType, blockSize);
+                throw std::runtime_error("failed to sub-allocate device memory!");
+            }
+            target = block.get();
+            blocks.push_back(std::move(block));
+        }
+
+        allocation.memory = target->memory;
+        allocation.offset = region.offset;
+        allocation.mapped = target->mapped != nullptr ? static_cast<char*>(target->mapped) + region.offset : nullptr;
+        allocation.block = target;
+        allocation.handle = region.handle;
+        memoryTracker.OnAllocate(allocation.id, category, allocation.size);
+        return allocation;
+    }
+
+    void MemoryAllocator::Free(MemoryAllocation& allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        memoryTracker.OnFree(allocation.id);
+
+        if (allocation.block == nullptr)
+        {
+            FreeDeviceMemory(allocation.memory, allocation.memoryType, allocation.size);
+            dedicatedAllocationCount--;
+            dedicatedBytes -= allocation.size;
+            allocation = MemoryAllocation{};
+            return;
+        }
+
+        auto block = static_cast<MemoryBlock*>(allocation.block);
+        block->metadata.Free(allocation.handle);
+        allocation = MemoryAllocation{};
+
+        // Keep one empty block of each pool, so resource created and destroyed every frame doesn't
+        // allocate device memory each time.
+        if (block->metadata.IsEmpty())
+        {
+            auto sameEmptyPool = [&](const std::unique_ptr<MemoryBlock>& other)
+            {
+                return other.get() != block && other->memoryType == block->memoryType &&
+                    other->linear == block->linear && other->metadata.IsEmpty();
+            };
+            if (std::any_of(blocks.begin(), blocks.end(), sameEmptyPool))
+            {
+                FreeDeviceMemory(block->memory, block->memoryType, block->metadata.GetSize());
+                blocks.erase(std::find_if(blocks.begin(), blocks.end(),
+                                          [&](const std::unique_ptr<MemoryBlock>& other)
+                                          {
+                                              return other.get() == block;
+                                          }));
+            }
+        }
+    }
+
+    bool MemoryAllocator::GetMappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset,
+                                         VkMappedMemoryRange& range) const
+    {
+        if (memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+        {
+            return false;
+        }
+
+        // Range must be aligned to atom size, but can't go past end of memory object.
+        VkDeviceSize memorySize = allocation.block != nullptr
+                                      ? static_cast<const MemoryBlock*>(allocation.block)->metadata.GetSize()
+                                      : allocation.size;
+        VkDeviceSize begin = allocation.offset + offset;
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+        range = {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = AlignDown(begin, nonCoherentAtomSize);
+        range.size = std::min(AlignUp(end, nonCoherentAtomSize), memorySize) - range.offset;
+        return true;
+    }
+
+    VkResult MemoryAllocator::Flush(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        VkMappedMemoryRange range;
+        if (!GetMappedRange(allocation, size, offset, range))
+        {
+            return VK_SUCCESS;
+        }
+        return vkFlushMappedMemoryRanges(device, 1, &range);
+    }
+
+    VkResult MemoryAllocator::Invalidate(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        VkMappedMemoryRange range;
+        if (!GetMappedRange(allocation, size, offset, range))
+        {
+            return VK_SUCCESS;
+        }
+        return vkInvalidateMappedMemoryRanges(device, 1, &range);
+    }
+
+    MemoryAllocator::Statistics MemoryAllocator::GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        Statistics statistics{};
+        statistics.blockCount = static_cast<uint32_t>(blocks.size());
+        statistics.dedicatedAllocationCount = dedicatedAllocationCount;
+        statistics.dedicatedBytes = dedicatedBytes;
+        statistics.allocationCount = dedicatedAllocationCount;
+
+        double weightedFragmentation = 0.0;
+        for (auto& block : blocks)
+        {
+            auto blockStatistics = block->metadata.GetStatistics();
+            statistics.blockBytes += blockStatistics.size;
+            statistics.usedBytes += blockStatistics.usedBytes;
+            statistics.freeBytes += blockStatistics.freeBytes;
+            statistics.allocationCount += blockStatistics.allocationCount;
+            statistics.freeRegionCount += blockStatistics.freeRegionCount;
+            statistics.largestFreeRegion = std::max(statistics.largestFreeRegion, blockStatistics.largestFreeRegion);
+            if (blockStatistics.freeBytes > 0)
+            {
+                weightedFragmentation += static_cast<double>(blockStatistics.freeBytes - blockStatistics.largestFreeRegion);
+            }
+        }
+        if (statistics.freeBytes > 0)
+        {
+            statistics.fragmentation = weightedFragmentation / static_cast<double>(statistics.freeBytes);
+        }
+        return statistics;
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "MemoryTracker.hpp"
+#include "TlsfMetadata.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Thrown when device memory is exhausted. Caller can release other resources and try again.
+    /// </summary>
+    class OutOfMemoryError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /// <summary>
+    /// Part of device memory given to single buffer or image.
+    /// </summary>
+    struct MemoryAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Start of allocation if memory is host visible, host visible memory stays mapped all the time.
+        void* mapped = nullptr;
+        uint32_t memoryType = 0;
+
+        // Used by allocator only
+        void* block = nullptr;
+        uint32_t handle = TlsfMetadata::INVALID_HANDLE;
+        uint64_t id = 0;
+    };
+
+    /// <summary>
+    /// Sub-allocates buffers and images from large device memory blocks, so number of vkAllocateMemory calls
+    /// stays low. Each memory type has separate blocks for linear (buffers) and optimal (images) resources,
+    /// so bufferImageGranularity never has to be considered inside block. Big resources get dedicated memory.
+    /// </summary>
+    class MemoryAllocator
+    {
+    public:
+        static constexpr VkDeviceSize PREFERRED_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        /// <summary>
+        /// Fragmentation statistics of all blocks.
+        /// </summary>
+        struct Statistics
+        {
+            uint32_t blockCount = 0;
+            uint32_t dedicatedAllocationCount = 0;
+            uint32_t allocationCount = 0;
+            VkDeviceSize blockBytes = 0;
+            VkDeviceSize dedicatedBytes = 0;
+            VkDeviceSize usedBytes = 0;
+            VkDeviceSize freeBytes = 0;
+            VkDeviceSize largestFreeRegion = 0;
+            uint32_t freeRegionCount = 0;
+            // 0 when all free space of block is one region, close to 1 when it is split to many small ones.
+            // Average of all blocks weighted by their free space.
+            double fragmentation = 0.0;
+        };
+
+        /// <summary>
+        /// Create allocator without any blocks.
+        /// </summary>
+        /// <param name="device"> Logical device</param>
+        /// <param name="physicalDevice"> Physical device of logical device</param>
+        /// <param name="memoryTracker"> Tracker to record all allocations into</param>
+        MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, MemoryTracker& memoryTracker);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        /// <summary>
+        /// Allocate memory for resource.
+        /// </summary>
+        /// <param name="requirements"> Requirements of resource which will be bound to memory</param>
+        /// <param name="memoryType"> Index of memory type, found with Device::FindMemoryType</param>
+        /// <param name="category"> What memory is used for</param>
+        /// <param name="linear"> true for buffers and linear images, false for optimal tiling images</param>
+        /// <returns> Allocated memory</returns>
+        /// <exception cref="OutOfMemoryError"> Device memory is exhausted</exception>
+        MemoryAllocation Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType,
+                                  MemoryCategory category, bool linear);
+
+        /// <summary>
+        /// Return memory to its block, empty blocks are released except last one of each pool.
+        /// </summary>
+        /// <param name="allocation"> Allocation to free, reset to empty state</param>
+        void Free(MemoryAllocation& allocation);
+
+        /// <summary>
+        /// Flush host writes to non-coherent memory. Range is extended to nonCoherentAtomSize.
+        /// </summary>
+        /// <param name="allocation"> Allocation to flush</param>
+        /// <param name="size"> Size of range or VK_WHOLE_SIZE</param>
+        /// <param name="offset"> Offset of range from allocation start</param>
+        /// <returns> vkFlushMappedMemoryRanges result</returns>
+        VkResult Flush(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+        /// <summary>
+        /// Make device writes to non-coherent memory visible to host. Range is extended to nonCoherentAtomSize.
+        /// </summary>
+        /// <param name="allocation"> Allocation to invalidate</param>
+        /// <param name="size"> Size of range or VK_WHOLE_SIZE</param>
+        /// <param name="offset"> Offset of range from allocation start</param>
+        /// <returns> vkInvalidateMappedMemoryRanges result</returns>
+        VkResult Invalidate(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct MemoryBlock
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            void* mapped = nullptr;
+            uint32_t memoryType = 0;
+            bool linear = true;
+            TlsfMetadata metadata;
+
+            MemoryBlock(VkDeviceSize size) : metadata(size)
+            {
+            }
+        };
+
+        /// <summary>
+        /// Allocate and map whole device memory object.
+        /// </summary>
+        VkDeviceMemory AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, void** mapped);
+        void FreeDeviceMemory(VkDeviceMemory memory, uint32_t memoryType, VkDeviceSize size);
+
+        VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+
+        /// <summary>
+        /// Get mapped range of allocation aligned to nonCoherentAtomSize, false if memory is coherent.
+        /// </summary>
+        bool GetMappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset,
+                            VkMappedMemoryRange& range) const;
+
+        VkDevice device;
+        MemoryTracker& memoryTracker;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        uint32_t dedicatedAllocationCount = 0;
+        VkDeviceSize dedicatedBytes = 0;
+        uint64_t nextAllocationId = 1;
+    };
+}
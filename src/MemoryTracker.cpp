@@ -0,0 +1,192 @@
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace VulkanEngine
+{
+    const char* MemoryCategoryName(MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::Vertex:
+            return "vertex";
+        case MemoryCategory::Index:
+            return "index";
+        case MemoryCategory::Uniform:
+            return "uniform";
+        case MemoryCategory::Staging:
+            return "staging";
+        case MemoryCategory::Texture:
+            return "texture";
+        case MemoryCategory::Attachment:
+            return "attachment";
+        default:
+            return "other";
+        }
+    }
+
+    MemoryTracker::MemoryTracker(std::vector<uint32_t> memoryTypeHeaps, std::vector<uint64_t> heapSizes,
+                                 uint32_t maxAllocationCount):
+        memoryTypeHeaps(std::move(memoryTypeHeaps)),
+        heapSizes(std::move(heapSizes)),
+        maxAllocationCount(maxAllocationCount),
+        memoryTypes(this->memoryTypeHeaps.size()),
+        heaps(this->heapSizes.size())
+    {
+    }
+
+    void MemoryTracker::Add(Usage& usage, uint64_t size)
+    {
+        usage.currentBytes += size;
+        usage.allocationCount++;
+        usage.totalAllocations++;
+        usage.peakBytes = std::max(usage.peakBytes, usage.currentBytes);
+        usage.peakAllocationCount = std::max(usage.peakAllocationCount, usage.allocationCount);
+    }
+
+    void MemoryTracker::Remove(Usage& usage, uint64_t size)
+    {
+        usage.currentBytes -= size;
+        usage.allocationCount--;
+    }
+
+    void MemoryTracker::OnAllocate(uint64_t handle, MemoryCategory category, uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        allocations[handle] = {category, size};
+        Add(total, size);
+        Add(categories[static_cast<size_t>(category)], size);
+    }
+
+    void MemoryTracker::OnFree(uint64_t handle)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = allocations.find(handle);
+        if (it == allocations.end())
+        {
+            return;
+        }
+
+        Allocation allocation = it->second;
+        allocations.erase(it);
+        Remove(total, allocation.size);
+        Remove(categories[static_cast<size_t>(allocation.category)], allocation.size);
+    }
+
+    void MemoryTracker::OnDeviceMemoryAllocate(uint32_t memoryType, uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        Add(deviceMemory, size);
+        Add(memoryTypes.at(memoryType), size);
+        Add(heaps.at(memoryTypeHeaps[memoryType]), size);
+
+        // Warn once each time limit is approached, so growth is visible before allocations start failing.
+        auto warningCount = static_cast<uint32_t>(maxAllocationCount * ALLOCATION_COUNT_WARNING_RATIO);
+        if (!allocationCountWarned && deviceMemory.allocationCount >= warningCount)
+        {
+            allocationCountWarned = true;
+            std::cerr << "warning: " << deviceMemory.allocationCount << " device memory allocations, limit is "
+                << maxAllocationCount << std::endl;
+        }
+    }
+
+    void MemoryTracker::OnDeviceMemoryFree(uint32_t memoryType, uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        Remove(deviceMemory, size);
+        Remove(memoryTypes.at(memoryType), size);
+        Remove(heaps.at(memoryTypeHeaps[memoryType]), size);
+
+        if (deviceMemory.allocationCount < static_cast<uint32_t>(maxAllocationCount * ALLOCATION_COUNT_WARNING_RATIO))
+        {
+            allocationCountWarned = false;
+        }
+    }
+
+    MemoryTracker::Usage MemoryTracker::GetTotalUsage() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return total;
+    }
+
+    MemoryTracker::Usage MemoryTracker::GetCategoryUsage(MemoryCategory category) const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return categories.at(static_cast<size_t>(category));
+    }
+
+    MemoryTracker::Usage MemoryTracker::GetDeviceMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return deviceMemory;
+    }
+
+    MemoryTracker::Usage MemoryTracker::GetMemoryTypeUsage(uint32_t memoryType) const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return memoryTypes.at(memoryType);
+    }
+
+    MemoryTracker::Usage MemoryTracker::GetHeapUsage(uint32_t heap) const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return heaps.at(heap);
+    }
+
+    static void WriteUsage(std::ostream& stream, const std::string& name, const MemoryTracker::Usage& usage)
+    {
+        constexpr double MB = 1024.0 * 1024.0;
+        stream << "  " << std::left << std::setw(16) << name << std::right
+            << std::setw(10) << usage.currentBytes / MB << " MB"
+            << std::setw(10) << usage.peakBytes / MB << " MB peak"
+            << std::setw(8) << usage.allocationCount << " allocations"
+            << std::setw(8) << usage.peakAllocationCount << " peak"
+            << std::setw(10) << usage.totalAllocations << " total\n";
+    }
+
+    void MemoryTracker::WriteReport(std::ostream& stream) const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto flags = stream.flags();
+        stream << std::fixed << std::setprecision(2);
+
+        stream << "resource memory:\n";
+        WriteUsage(stream, "total", total);
+        for (size_t i = 0; i < categories.size(); i++)
+        {
+            if (categories[i].totalAllocations > 0)
+            {
+                WriteUsage(stream, MemoryCategoryName(static_cast<MemoryCategory>(i)), categories[i]);
+            }
+        }
+
+        stream << "device memory (allocation limit " << maxAllocationCount << "):\n";
+        WriteUsage(stream, "total", deviceMemory);
+        for (size_t i = 0; i < memoryTypes.size(); i++)
+        {
+            if (memoryTypes[i].totalAllocations > 0)
+            {
+                WriteUsage(stream, "type " + std::to_string(i) + " (heap " + std::to_string(memoryTypeHeaps[i]) + ")",
+                           memoryTypes[i]);
+            }
+        }
+
+        for (size_t i = 0; i < heaps.size(); i++)
+        {
+            if (heaps[i].totalAllocations > 0)
+            {
+                WriteUsage(stream, "heap " + std::to_string(i), heaps[i]);
+                stream << "    of " << heapSizes[i] / (1024.0 * 1024.0) << " MB heap\n";
+            }
+        }
+
+        if (!allocations.empty())
+        {
+            stream << allocations.size() << " resource allocations still alive\n";
+        }
+        stream.flags(flags);
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// What device memory is used for.
+    /// </summary>
+    enum class MemoryCategory : uint32_t
+    {
+        Vertex,
+        Index,
+        Uniform,
+        Staging,
+        Texture,
+        Attachment,
+        Other,
+        Count
+    };
+
+    const char* MemoryCategoryName(MemoryCategory category);
+
+    /// <summary>
+    /// Keeps track of memory given to resources by category and of device memory objects by memory type and heap.
+    /// Resources are sub-allocated from device memory blocks, so these two differ.
+    /// Allocator reports each allocation and free, tracker only does bookkeeping.
+    /// </summary>
+    class MemoryTracker
+    {
+    public:
+        /// <summary>
+        /// Memory usage of single category, memory type or heap.
+        /// </summary>
+        struct Usage
+        {
+            uint64_t currentBytes = 0;
+            uint64_t peakBytes = 0;
+            uint32_t allocationCount = 0;
+            uint32_t peakAllocationCount = 0;
+            uint64_t totalAllocations = 0;
+        };
+
+        // Warning is printed when allocation count reaches this part of device limit.
+        static constexpr double ALLOCATION_COUNT_WARNING_RATIO = 0.9;
+
+        /// <summary>
+        /// Create tracker for device memory layout.
+        /// </summary>
+        /// <param name="memoryTypeHeaps"> Heap index of each memory type</param>
+        /// <param name="heapSizes"> Size of each heap in bytes</param>
+        /// <param name="maxAllocationCount"> Device limit of simultaneous allocations</param>
+        MemoryTracker(std::vector<uint32_t> memoryTypeHeaps, std::vector<uint64_t> heapSizes,
+                      uint32_t maxAllocationCount);
+
+        MemoryTracker(const MemoryTracker&) = delete;
+        MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+        /// <summary>
+        /// Record memory given to resource.
+        /// </summary>
+        /// <param name="handle"> Unique value identifying allocation</param>
+        /// <param name="category"> What memory is used for</param>
+        /// <param name="size"> Size in bytes</param>
+        void OnAllocate(uint64_t handle, MemoryCategory category, uint64_t size);
+
+        /// <summary>
+        /// Record free of resource memory. Unknown handles are ignored.
+        /// </summary>
+        /// <param name="handle"> Value passed to OnAllocate</param>
+        void OnFree(uint64_t handle);
+
+        /// <summary>
+        /// Record vkAllocateMemory call.
+        /// </summary>
+        /// <param name="memoryType"> Index of memory type</param>
+        /// <param name="size"> Size in bytes</param>
+        void OnDeviceMemoryAllocate(uint32_t memoryType, uint64_t size);
+
+        /// <summary>
+        /// Record vkFreeMemory call.
+        /// </summary>
+        /// <param name="memoryType"> Index of memory type</param>
+        /// <param name="size"> Size in bytes</param>
+        void OnDeviceMemoryFree(uint32_t memoryType, uint64_t size);
+
+        // Memory of all resources
+        Usage GetTotalUsage() const;
+        Usage GetCategoryUsage(MemoryCategory category) const;
+        // Device memory objects
+        Usage GetDeviceMemoryUsage() const;
+        Usage GetMemoryTypeUsage(uint32_t memoryType) const;
+        Usage GetHeapUsage(uint32_t heap) const;
+
+        uint32_t GetMaxAllocationCount() const
+        {
+            return maxAllocationCount;
+        }
+
+        /// <summary>
+        /// Write human readable table of usage of all categories, memory types and heaps.
+        /// </summary>
+        /// <param name="stream"> Output stream</param>
+        void WriteReport(std::ostream& stream) const;
+
+    private:
+        struct Allocation
+        {
+            MemoryCategory category;
+            uint64_t size;
+        };
+
+        static void Add(Usage& usage, uint64_t size);
+        static void Remove(Usage& usage, uint64_t size);
+
+        std::vector<uint32_t> memoryTypeHeaps;
+        std::vector<uint64_t> heapSizes;
+        uint32_t maxAllocationCount;
+        bool allocationCountWarned = false;
+
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Allocation> allocations;
+        Usage total;
+        std::array<Usage, static_cast<size_t>(MemoryCategory::Count)> categories;
+        Usage deviceMemory;
+        std::vector<Usage> memoryTypes;
+        std::vector<Usage> heaps;
+    };
+}
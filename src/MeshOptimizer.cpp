@@ -0,0 +1,288 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    MeshOptimizer::VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices,
+                                                                           uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStatistics statistics{};
+        if (indices.empty())
+        {
+            return statistics;
+        }
+
+        // Vertex is in FIFO cache while fewer than cacheSize vertices were transformed after it
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t uniqueVertices = 0;
+        for (uint32_t index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                uniqueVertices++;
+            }
+            if (time - cacheTime[index] > cacheSize)
+            {
+                cacheTime[index] = time++;
+                misses++;
+            }
+        }
+
+        statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        statistics.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+        return statistics;
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeVertexCache");
+        assert(indices.size() % 3 == 0);
+        if (indices.empty())
+        {
+            return;
+        }
+
+        // Triangles of each vertex, lists of all vertices are stored in one array
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (uint32_t index : indices)
+        {
+            liveTriangles[index]++;
+        }
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::partial_sum(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        std::vector<bool> emitted(indices.size() / 3, false);
+        // Recently referenced vertices, used to continue where the last fan ended
+        std::vector<uint32_t> deadEnd;
+        deadEnd.reserve(indices.size());
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        // Vertices before cursor have no live triangles left
+        uint32_t cursor = 0;
+        int64_t fanning = indices[0];
+        while (fanning >= 0)
+        {
+            // Emit all remaining triangles around fanning vertex
+            candidates.clear();
+            auto vertex = static_cast<uint32_t>(fanning);
+            for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+            {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    uint32_t index = indices[triangle * 3 + k];
+                    result.push_back(index);
+                    deadEnd.push_back(index);
+                    candidates.push_back(index);
+                    liveTriangles[index]--;
+                    if (time - cacheTime[index] > cacheSize)
+                    {
+                        cacheTime[index] = time++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            // Next fan is around the oldest candidate which stays in cache while its triangles are emitted
+            fanning = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t candidate : candidates)
+            {
+                if (liveTriangles[candidate] == 0)
+                {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - cacheTime[candidate] + 2 * liveTriangles[candidate] <= cacheSize)
+                {
+                    priority = time - cacheTime[candidate];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanning = candidate;
+                }
+            }
+
+            // Dead end, prefer recently used vertices, then any vertex with triangles left
+            while (fanning < 0 && !deadEnd.empty())
+            {
+                uint32_t candidate = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[candidate] > 0)
+                {
+                    fanning = candidate;
+                }
+            }
+            for (; fanning < 0 && cursor < vertexCount; cursor++)
+            {
+                if (liveTriangles[cursor] > 0)
+                {
+                    fanning = cursor;
+                }
+            }
+        }
+
+        indices.swap(result);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Model::Vertex>& vertices,
+                                         float threshold)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeOverdraw");
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2)
+        {
+            return;
+        }
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        VertexCacheStatistics before = AnalyzeVertexCache(indices, vertexCount);
+
+        // Triangle missing cache with all vertices starts new fan sequence, moving it costs almost nothing
+        std::vector<size_t> clusterStarts;
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = CACHE_SIZE + 1;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            uint32_t misses = 0;
+            for (size_t k = 0; k < 3; k++)
+            {
+                uint32_t index = indices[t * 3 + k];
+                if (time - cacheTime[index] > CACHE_SIZE)
+                {
+                    cacheTime[index] = time++;
+                    misses++;
+                }
+            }
+            if (misses == 3 || t == 0)
+            {
+                clusterStarts.push_back(t);
+            }
+        }
+        if (clusterStarts.size() < 2)
+        {
+            return;
+        }
+        clusterStarts.push_back(triangleCount);
+
+        // Area weighted centroid and normal of clusters
+        size_t clusterCount = clusterStarts.size() - 1;
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{0.f});
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{0.f});
+        std::vector<float> clusterAreas(clusterCount, 0.f);
+        glm::vec3 meshCentroid{0.f};
+        float meshArea = 0.f;
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+            {
+                const glm::vec3& p0 = vertices[indices[t * 3]].position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                clusterCentroids[c] += (p0 + p1 + p2) / 3.f * area;
+                clusterNormals[c] += normal;
+                clusterAreas[c] += area;
+            }
+            meshCentroid += clusterCentroids[c];
+            meshArea += clusterAreas[c];
+        }
+        if (meshArea == 0.f)
+        {
+            return;
+        }
+        meshCentroid /= meshArea;
+
+        // Clusters facing away from center are likely in front, so they are drawn first
+        std::vector<float> sortKeys(clusterCount, 0.f);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            float normalLength = glm::length(clusterNormals[c]);
+            if (clusterAreas[c] > 0.f && normalLength > 0.f)
+            {
+                glm::vec3 centroid = clusterCentroids[c] / clusterAreas[c];
+                sortKeys[c] = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+            }
+        }
+        std::vector<size_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b)
+        {
+            return sortKeys[a] > sortKeys[b];
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (size_t c : order)
+        {
+            result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+        }
+
+        // Seams between reordered clusters cost some cache hits, keep cache order if they cost too much
+        VertexCacheStatistics after = AnalyzeVertexCache(result, vertexCount);
+        if (after.acmr <= before.acmr * threshold)
+        {
+            indices.swap(result);
+        }
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch(std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeVertexFetch");
+        constexpr uint32_t UNUSED = ~0u;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Model::Vertex> result;
+        result.reserve(vertices.size());
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(result);
+    }
+
+    MeshOptimizer::Report MeshOptimizer::Optimize(Model::ModelData& data)
+    {
+        PROFILE_SCOPE("MeshOptimizer::Optimize");
+        Report report{};
+        if (data.indices.empty())
+        {
+            return report;
+        }
+
+        report.before = AnalyzeVertexCache(data.indices, static_cast<uint32_t>(data.vertices.size()));
+        OptimizeVertexCache(data.indices, static_cast<uint32_t>(data.vertices.size()));
+        OptimizeOverdraw(data.indices, data.vertices);
+        OptimizeVertexFetch(data.vertices, data.indices);
+        report.after = AnalyzeVertexCache(data.indices, static_cast<uint32_t>(data.vertices.size()));
+        return report;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Model.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Reorders indexed triangle lists and their vertices for GPU. Meshes are first ordered for post-transform
+    /// vertex cache (Tipsify), then clusters of that order are sorted to reduce overdraw and finally vertices
+    /// are reordered in order of first use for vertex fetch locality.
+    /// </summary>
+    class MeshOptimizer
+    {
+    public:
+        // Cache size optimized for, FIFO cache of this size is also used for statistics
+        static constexpr uint32_t CACHE_SIZE = 16;
+        // Overdraw ordering is kept only if it raises ACMR less than this factor
+        static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+        struct VertexCacheStatistics
+        {
+            // Average cache miss ratio, transformed vertices per triangle, 0.5 is optimum for big meshes
+            float acmr = 0.f;
+            // Average transform to vertex ratio, transformed vertices per referenced vertex, 1 is optimum
+            float atvr = 0.f;
+        };
+
+        struct Report
+        {
+            VertexCacheStatistics before;
+            VertexCacheStatistics after;
+        };
+
+        /// <summary>
+        /// Simulate FIFO post-transform cache.
+        /// </summary>
+        /// <param name="indices"> Triangle list</param>
+        /// <param name="vertexCount"> Number of vertices indices point to</param>
+        /// <param name="cacheSize"> Number of cache entries</param>
+        /// <returns> Statistics of cache</returns>
+        static VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                                        uint32_t cacheSize = CACHE_SIZE);
+
+        /// <summary>
+        /// Reorder triangles for post-transform cache with Tipsify (Sander et al. 2007), linear in triangles.
+        /// </summary>
+        /// <param name="indices"> Triangle list, reordered in place</param>
+        /// <param name="vertexCount"> Number of vertices indices point to</param>
+        /// <param name="cacheSize"> Number of cache entries</param>
+        static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                        uint32_t cacheSize = CACHE_SIZE);
+
+        /// <summary>
+        /// Sort clusters of cache optimized triangle list, so triangles facing out of mesh are drawn first and
+        /// occlude the rest. Cluster starts at every triangle which misses cache with all its vertices.
+        /// </summary>
+        /// <param name="indices"> Triangle list optimized by OptimizeVertexCache, reordered in place</param>
+        /// <param name="vertices"> Vertices indices point to</param>
+        /// <param name="threshold"> Maximal allowed increase of ACMR</param>
+        static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Model::Vertex>& vertices,
+                                     float threshold = OVERDRAW_THRESHOLD);
+
+        /// <summary>
+        /// Reorder vertices in order indices reference them, unreferenced vertices are removed.
+        /// </summary>
+        /// <param name="vertices"> Vertices, reordered in place</param>
+        /// <param name="indices"> Triangle list, remapped in place</param>
+        static void OptimizeVertexFetch(std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        /// <summary>
+        /// Run all passes on indexed mesh. Meshes without indices are left as they are.
+        /// </summary>
+        /// <param name="data"> Mesh to optimize</param>
+        /// <returns> Vertex cache statistics before and after</returns>
+        static Report Optimize(Model::ModelData& data);
+    };
+}
@@ -0,0 +1,361 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    static constexpr uint32_t NO_GROUP = ~0u;
+
+    /// <summary>
+    /// Symmetric quadric Q(p) = p^T A p + 2 b.p + c, weighted sum of squared distances to planes.
+    /// Sum of weights is kept, so error is weighted mean of squared distances and doesn't depend on scale
+    /// or density of mesh.
+    /// </summary>
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight)
+        {
+            Quadric q;
+            q.a00 = weight * normal.x * normal.x;
+            q.a01 = weight * normal.x * normal.y;
+            q.a02 = weight * normal.x * normal.z;
+            q.a11 = weight * normal.y * normal.y;
+            q.a12 = weight * normal.y * normal.z;
+            q.a22 = weight * normal.z * normal.z;
+            q.b0 = weight * normal.x * distance;
+            q.b1 = weight * normal.y * distance;
+            q.b2 = weight * normal.z * distance;
+            q.c = weight * distance * distance;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a00 += other.a00;
+            a01 += other.a01;
+            a02 += other.a02;
+            a11 += other.a11;
+            a12 += other.a12;
+            a22 += other.a22;
+            b0 += other.b0;
+            b1 += other.b1;
+            b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        /// <summary>
+        /// Weighted mean squared distance of point to planes.
+        /// </summary>
+        double Evaluate(const glm::dvec3& p) const
+        {
+            if (weight <= 0.0)
+            {
+                return 0.0;
+            }
+            double result = p.x * (a00 * p.x + a01 * p.y + a02 * p.z) +
+                p.y * (a01 * p.x + a11 * p.y + a12 * p.z) +
+                p.z * (a02 * p.x + a12 * p.y + a22 * p.z) +
+                2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            // Rounding can make it slightly negative
+            return std::max(result, 0.0) / weight;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    static float AttributeDistance(const Model::Vertex& a, const Model::Vertex& b)
+    {
+        return glm::length(a.normal - b.normal) + glm::length(a.texCord - b.texCord) + glm::length(a.color - b.color);
+    }
+
+    std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Model::Vertex>& vertices,
+                                                   const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                                                   float maxError, float* resultError)
+    {
+        PROFILE_SCOPE("MeshSimplifier::Simplify");
+        assert(indices.size() % 3 == 0);
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        if (resultError != nullptr)
+        {
+            *resultError = 0.f;
+        }
+
+        // Group vertices with same position, topology and error are computed on groups
+        std::vector<uint32_t> sorted(vertexCount);
+        std::iota(sorted.begin(), sorted.end(), 0u);
+        auto lessPosition = [&vertices](uint32_t a, uint32_t b)
+        {
+            const glm::vec3& pa = vertices[a].position;
+            const glm::vec3& pb = vertices[b].position;
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        };
+        std::sort(sorted.begin(), sorted.end(), lessPosition);
+        std::vector<uint32_t> groupOf(vertexCount);
+        // Vertices of each group, as offsets into sorted
+        std::vector<uint32_t> groupOffsets;
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            if (i == 0 || vertices[sorted[i]].position != vertices[sorted[i - 1]].position)
+            {
+                groupOffsets.push_back(i);
+            }
+            groupOf[sorted[i]] = static_cast<uint32_t>(groupOffsets.size() - 1);
+        }
+        groupOffsets.push_back(vertexCount);
+        auto groupCount = static_cast<uint32_t>(groupOffsets.size() - 1);
+        auto groupPosition = [&](uint32_t group)
+        {
+            return glm::dvec3{vertices[sorted[groupOffsets[group]]].position};
+        };
+
+        BoundingBox bounds{};
+        for (const auto& vertex : vertices)
+        {
+            bounds.Extend(vertex.position);
+        }
+        double extent = std::max(static_cast<double>(glm::length(bounds.GetExtent())), 1e-12);
+        double maxCost = (maxError * extent) * (maxError * extent);
+
+        // Quadrics of triangle planes weighted by area, and of planes perpendicular to border edges weighted
+        // by squared edge length, so both weights are areas and their sum normalizes error to squared distance
+        std::vector<Quadric> quadrics(groupCount);
+        std::vector<std::pair<uint64_t, uint32_t>> edges;
+        edges.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            glm::dvec3 p0 = groupPosition(groupOf[indices[i]]);
+            glm::dvec3 p1 = groupPosition(groupOf[indices[i + 1]]);
+            glm::dvec3 p2 = groupPosition(groupOf[indices[i + 2]]);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(normal);
+            if (area == 0.0)
+            {
+                continue;
+            }
+            normal /= area;
+            Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), area * 0.5);
+            for (size_t k = 0; k < 3; k++)
+            {
+                uint32_t a = groupOf[indices[i + k]];
+                uint32_t b = groupOf[indices[i + (k + 1) % 3]];
+                quadrics[a] += quadric;
+                edges.push_back({static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b),
+                                 static_cast<uint32_t>(i / 3)});
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            bool shared = (i > 0 && edges[i - 1].first == edges[i].first) ||
+                (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+            if (shared)
+            {
+                continue;
+            }
+            auto a = static_cast<uint32_t>(edges[i].first >> 32);
+            auto b = static_cast<uint32_t>(edges[i].first & 0xffffffffu);
+            size_t triangle = edges[i].second * 3;
+            glm::dvec3 pa = groupPosition(a);
+            glm::dvec3 pb = groupPosition(b);
+            glm::dvec3 faceNormal = glm::cross(groupPosition(groupOf[indices[triangle + 1]]) -
+                                               groupPosition(groupOf[indices[triangle]]),
+                                               groupPosition(groupOf[indices[triangle + 2]]) -
+                                               groupPosition(groupOf[indices[triangle]]));
+            glm::dvec3 borderNormal = glm::cross(pb - pa, faceNormal);
+            double length = glm::length(borderNormal);
+            if (length == 0.0)
+            {
+                continue;
+            }
+            borderNormal /= length;
+            double edgeLength = glm::length(pb - pa);
+            Quadric quadric = Quadric::FromPlane(borderNormal, -glm::dot(borderNormal, pa),
+                                                 edgeLength * edgeLength * BORDER_WEIGHT);
+            quadrics[a] += quadric;
+            quadrics[b] += quadric;
+        }
+
+        std::vector<uint32_t> result = indices;
+        std::vector<uint32_t> collapseTo(groupCount, NO_GROUP);
+        std::vector<bool> locked(groupCount);
+        std::vector<uint32_t> adjacencyOffsets(groupCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<uint64_t> passEdges;
+        std::vector<Collapse> collapses;
+        double worstCost = 0.0;
+        while (result.size() > targetIndexCount)
+        {
+            // Unique edges of current triangles, each collapsed into its cheaper end
+            passEdges.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (size_t k = 0; k < 3; k++)
+                {
+                    uint32_t a = groupOf[result[i + k]];
+                    uint32_t b = groupOf[result[i + (k + 1) % 3]];
+                    passEdges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+                }
+            }
+            std::sort(passEdges.begin(), passEdges.end());
+            passEdges.erase(std::unique(passEdges.begin(), passEdges.end()), passEdges.end());
+            collapses.clear();
+            for (uint64_t edge : passEdges)
+            {
+                auto a = static_cast<uint32_t>(edge >> 32);
+                auto b = static_cast<uint32_t>(edge & 0xffffffffu);
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+                double costToA = quadric.Evaluate(groupPosition(a));
+                double costToB = quadric.Evaluate(groupPosition(b));
+                collapses.push_back(costToB <= costToA ? Collapse{a, b, costToB} : Collapse{b, a, costToA});
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return a.cost < b.cost;
+            });
+
+            // Triangles around each group
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t index : result)
+            {
+                adjacencyOffsets[groupOf[index] + 1]++;
+            }
+            std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+            adjacency.resize(result.size());
+            std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+            {
+                adjacency[fillOffsets[groupOf[result[i]]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            // Collapses of one pass don't touch neighborhood of each other, so checks see current geometry
+            std::fill(locked.begin(), locked.end(), false);
+            size_t triangleCount = result.size() / 3;
+            size_t collapsed = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (collapse.cost > maxCost || triangleCount * 3 <= targetIndexCount)
+                {
+                    break;
+                }
+                if (locked[collapse.from] || locked[collapse.to])
+                {
+                    continue;
+                }
+
+                // Collapse must not flip any remaining triangle around collapsed group
+                bool flips = false;
+                size_t removed = 0;
+                for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; a++)
+                {
+                    size_t triangle = adjacency[a] * 3;
+                    uint32_t groups[3] = {groupOf[result[triangle]], groupOf[result[triangle + 1]],
+                                          groupOf[result[triangle + 2]]};
+                    if (groups[0] == collapse.to || groups[1] == collapse.to || groups[2] == collapse.to)
+                    {
+                        removed++;
+                        continue;
+                    }
+                    glm::dvec3 before[3];
+                    glm::dvec3 after[3];
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        before[k] = groupPosition(groups[k]);
+                        after[k] = groupPosition(groups[k] == collapse.from ? collapse.to : groups[k]);
+                    }
+                    glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    // Turning by more than about 75 degrees is also rejected, it makes slivers standing on edge
+                    flips = glm::dot(normalBefore, normalAfter) <=
+                        MAX_NORMAL_DOT * glm::length(normalBefore) * glm::length(normalAfter);
+                }
+                if (flips)
+                {
+                    continue;
+                }
+
+                collapseTo[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                worstCost = std::max(worstCost, collapse.cost);
+                triangleCount -= removed;
+                collapsed++;
+                locked[collapse.from] = true;
+                locked[collapse.to] = true;
+                for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+                {
+                    size_t triangle = adjacency[a] * 3;
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        locked[groupOf[result[triangle + k]]] = true;
+                    }
+                }
+            }
+            if (collapsed == 0)
+            {
+                break;
+            }
+
+            // Move corners of collapsed groups to vertex of target with closest attributes, drop degenerates
+            size_t output = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t triangle[3];
+                for (size_t k = 0; k < 3; k++)
+                {
+                    uint32_t vertex = result[i + k];
+                    uint32_t target = collapseTo[groupOf[vertex]];
+                    if (target != NO_GROUP)
+                    {
+                        uint32_t best = sorted[groupOffsets[target]];
+                        for (uint32_t w = groupOffsets[target] + 1; w < groupOffsets[target + 1]; w++)
+                        {
+                            if (AttributeDistance(vertices[sorted[w]], vertices[vertex]) <
+                                AttributeDistance(vertices[best], vertices[vertex]))
+                            {
+                                best = sorted[w];
+                            }
+                        }
+                        vertex = best;
+                    }
+                    triangle[k] = vertex;
+                }
+                if (groupOf[triangle[0]] != groupOf[triangle[1]] && groupOf[triangle[1]] != groupOf[triangle[2]] &&
+                    groupOf[triangle[0]] != groupOf[triangle[2]])
+                {
+                    result[output++] = triangle[0];
+                    result[output++] = triangle[1];
+                    result[output++] = triangle[2];
+                }
+            }
+            result.resize(output);
+            for (uint32_t group = 0; group < groupCount; group++)
+            {
+                collapseTo[group] = NO_GROUP;
+            }
+        }
+
+        if (resultError != nullptr)
+        {
+            *resultError = static_cast<float>(std::sqrt(worstCost) / extent);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Model.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Mesh simplification with quadric error metric (Garland and Heckbert 1997). Edges are collapsed into one
+    /// of their vertices, so simplified mesh is new index buffer over original vertices and LODs can share
+    /// vertex buffer. Vertices with same position are collapsed together, each of them is replaced by vertex
+    /// of target position with closest attributes, so UV and normal seams don't open.
+    /// </summary>
+    class MeshSimplifier
+    {
+    public:
+        // Border edges are kept in place by planes perpendicular to them with this weight
+        static constexpr double BORDER_WEIGHT = 10.0;
+        // Collapse is rejected if it turns normal of any triangle so cosine of turn is at most this
+        static constexpr double MAX_NORMAL_DOT = 0.25;
+
+        /// <summary>
+        /// Simplify triangle list.
+        /// </summary>
+        /// <param name="vertices"> Vertices of mesh</param>
+        /// <param name="indices"> Triangle list</param>
+        /// <param name="targetIndexCount"> Number of indices to reach</param>
+        /// <param name="maxError"> Collapses with bigger error relative to mesh extent are not done, so result
+        /// may have more indices than targetIndexCount</param>
+        /// <param name="resultError"> Error of result relative to mesh extent, can be null</param>
+        /// <returns> Simplified triangle list</returns>
+        static std::vector<uint32_t> Simplify(const std::vector<Model::Vertex>& vertices,
+                                              const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                                              float maxError, float* resultError = nullptr);
+    };
+}
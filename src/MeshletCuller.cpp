@@ -0,0 +1,144 @@
+#include "MeshletCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    // Bounding sphere and normal cone of triangles of meshlet
+    static void ComputeBounds(Model::Meshlet& meshlet, const Model::Vertex* vertices, const uint16_t* indices,
+                              const std::vector<uint16_t>& meshletVertices)
+    {
+        BoundingBox box{};
+        for (uint16_t vertex : meshletVertices)
+        {
+            box.Extend(vertices[vertex].position);
+        }
+        meshlet.center = box.GetCenter();
+        meshlet.radius = 0.f;
+        for (uint16_t vertex : meshletVertices)
+        {
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[vertex].position - meshlet.center));
+        }
+
+        // Normals follow winding, which rasterizer culls by
+        std::vector<glm::vec3> normals;
+        glm::vec3 axis{0.f};
+        for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+        {
+            const glm::vec3& p0 = vertices[indices[i]].position;
+            glm::vec3 normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+            float area = glm::length(normal);
+            if (area > 0.f)
+            {
+                normals.push_back(normal / area);
+                axis += normals.back();
+            }
+        }
+        meshlet.coneAxis = glm::vec3{0.f};
+        meshlet.coneCutoff = 1.f;
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength == 0.f)
+        {
+            return;
+        }
+        axis /= axisLength;
+        float minDot = 1.f;
+        for (const auto& normal : normals)
+        {
+            minDot = std::min(minDot, glm::dot(normal, axis));
+        }
+        if (minDot > MeshletCuller::MIN_CONE_DOT)
+        {
+            meshlet.coneAxis = axis;
+            meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        }
+    }
+
+    std::vector<Model::Meshlet> MeshletCuller::Build(const std::vector<Model::Vertex>& vertices,
+                                                     const std::vector<uint16_t>& indices, const Model::Chunk& chunk)
+    {
+        PROFILE_SCOPE("MeshletCuller::Build");
+        std::vector<Model::Meshlet> meshlets;
+        const Model::Vertex* chunkVertices = vertices.data() + chunk.vertexOffset;
+
+        // Meshlet which last used vertex, so nothing has to be cleared when meshlet is closed
+        std::vector<uint32_t> vertexMeshlet(Model::MAX_CHUNK_VERTICES, ~0u);
+        std::vector<uint16_t> meshletVertices;
+        Model::Meshlet meshlet{};
+        meshlet.firstIndex = chunk.firstIndex;
+        meshlet.vertexOffset = chunk.vertexOffset;
+        auto finish = [&]()
+        {
+            ComputeBounds(meshlet, chunkVertices, indices.data() + meshlet.firstIndex, meshletVertices);
+            meshlets.push_back(meshlet);
+            meshlet.firstIndex += meshlet.indexCount;
+            meshlet.indexCount = 0;
+            meshletVertices.clear();
+        };
+
+        for (uint32_t i = chunk.firstIndex; i + 2 < chunk.firstIndex + chunk.indexCount; i += 3)
+        {
+            auto meshletIndex = static_cast<uint32_t>(meshlets.size());
+            uint32_t newVertices = 0;
+            for (uint32_t j = i; j < i + 3; j++)
+            {
+                newVertices += vertexMeshlet[indices[j]] != meshletIndex ? 1 : 0;
+            }
+            if (meshletVertices.size() + newVertices > Model::MAX_MESHLET_VERTICES ||
+                meshlet.indexCount == Model::MAX_MESHLET_TRIANGLES * 3)
+            {
+                finish();
+                meshletIndex++;
+            }
+
+            for (uint32_t j = i; j < i + 3; j++)
+            {
+                if (vertexMeshlet[indices[j]] != meshletIndex)
+                {
+                    vertexMeshlet[indices[j]] = meshletIndex;
+                    meshletVertices.push_back(indices[j]);
+                }
+            }
+            meshlet.indexCount += 3;
+        }
+        if (meshlet.indexCount > 0)
+        {
+            finish();
+        }
+        return meshlets;
+    }
+
+    uint32_t MeshletCuller::Cull(const Model::Meshlet* meshlets, uint32_t meshletCount, const Frustum& frustum,
+                                 const glm::vec3& cameraPosition, uint32_t firstIndex, int32_t vertexOffset,
+                                 std::vector<VkDrawIndexedIndirectCommand>& commands)
+    {
+        PROFILE_SCOPE("MeshletCuller::Cull");
+        uint32_t visible = 0;
+        // Index after last appended draw, draw is extended if next visible meshlet starts there
+        uint32_t nextIndex = ~0u;
+        for (uint32_t i = 0; i < meshletCount; i++)
+        {
+            const Model::Meshlet& meshlet = meshlets[i];
+            if (IsBackFacing(meshlet, cameraPosition) || IsOutsideFrustum(meshlet, frustum))
+            {
+                continue;
+            }
+            visible++;
+
+            int32_t meshletVertexOffset = vertexOffset + static_cast<int32_t>(meshlet.vertexOffset);
+            if (firstIndex + meshlet.firstIndex == nextIndex && commands.back().vertexOffset == meshletVertexOffset)
+            {
+                commands.back().indexCount += meshlet.indexCount;
+            }
+            else
+            {
+                commands.push_back({meshlet.indexCount, 1, firstIndex + meshlet.firstIndex, meshletVertexOffset, 0});
+            }
+            nextIndex = firstIndex + meshlet.firstIndex + meshlet.indexCount;
+        }
+        return visible;
+    }
+}
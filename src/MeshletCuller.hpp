@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.hpp"
+#include "Model.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Meshlet clustering of model chunks and culling of meshlets on CPU. Meshlets are consecutive triangles
+    /// of chunk in order left by MeshOptimizer, so index buffer stays as it is and visible meshlets are plain
+    /// index ranges. Culling needs no device, ranges are emitted in layout of indirect draw commands.
+    /// </summary>
+    class MeshletCuller
+    {
+    public:
+        // Cone culling is disabled if triangle normals are spread more than this cosine from axis
+        static constexpr float MIN_CONE_DOT = 0.1f;
+
+        /// <summary>
+        /// Split triangles of chunk into meshlets of at most Model::MAX_MESHLET_VERTICES vertices and
+        /// Model::MAX_MESHLET_TRIANGLES triangles.
+        /// </summary>
+        /// <param name="vertices"> Vertices chunk vertex offset points to</param>
+        /// <param name="indices"> 16 bit indices of all chunks</param>
+        /// <param name="chunk"> Chunk to split</param>
+        /// <returns> Meshlets in order of their indices</returns>
+        static std::vector<Model::Meshlet> Build(const std::vector<Model::Vertex>& vertices,
+                                                 const std::vector<uint16_t>& indices, const Model::Chunk& chunk);
+
+        /// <summary>
+        /// Check if bounding sphere of meshlet is outside of frustum.
+        /// </summary>
+        static bool IsOutsideFrustum(const Model::Meshlet& meshlet, const Frustum& frustum)
+        {
+            return !frustum.IsSphereVisible(meshlet.center, meshlet.radius);
+        }
+
+        /// <summary>
+        /// Check if all triangles of meshlet face away from camera anywhere in bounding sphere.
+        /// </summary>
+        static bool IsBackFacing(const Model::Meshlet& meshlet, const glm::vec3& cameraPosition)
+        {
+            glm::vec3 direction = meshlet.center - cameraPosition;
+            return glm::dot(direction, meshlet.coneAxis) >=
+                meshlet.coneCutoff * glm::length(direction) + meshlet.radius;
+        }
+
+        /// <summary>
+        /// Append draws of visible meshlets, consecutive visible meshlets of same chunk share one draw.
+        /// </summary>
+        /// <param name="meshlets"> Meshlets to cull</param>
+        /// <param name="meshletCount"> Number of meshlets</param>
+        /// <param name="frustum"> View frustum in model space</param>
+        /// <param name="cameraPosition"> Camera position in model space</param>
+        /// <param name="firstIndex"> Added to first index of each draw</param>
+        /// <param name="vertexOffset"> Added to vertex offset of each draw</param>
+        /// <param name="commands"> Draws of visible index ranges</param>
+        /// <returns> Number of visible meshlets</returns>
+        static uint32_t Cull(const Model::Meshlet* meshlets, uint32_t meshletCount, const Frustum& frustum,
+                             const glm::vec3& cameraPosition, uint32_t firstIndex, int32_t vertexOffset,
+                             std::vector<VkDrawIndexedIndirectCommand>& commands);
+    };
+}
@@ -1,127 +1,458 @@
 #pragma once
 #include "Model.hpp"
-#include "Utils.hpp"
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define  GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-
+#include "Profiler.hpp"
+#include "UploadContext.hpp"
+#include "GeometryPool.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletCuller.hpp"
+#include "ObjParser.hpp"
+#include "CookedMesh.hpp"
+#include "VertexCompression.hpp"
+#include "VertexDeduplicator.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
 #include <stdexcept>
-#include <unordered_map>
 
-namespace std
+namespace VulkanEngine
 {
-    /// <summary>
-    /// Helper hashing function.
-    /// </summary>
-    template <>
-    struct hash<VulkanEngine::Model::Vertex>
+    // Bounding box and bounding sphere of vertices, sphere by Ritter's algorithm or around box if that is smaller
+    static void ComputeVertexBounds(const std::vector<Model::Vertex>& vertices, BoundingBox& bounds,
+                                    BoundingSphere& sphere)
     {
-        size_t operator()(VulkanEngine::Model::Vertex const& vertex) const
+        bounds = {};
+        sphere = {};
+        if (vertices.empty())
         {
-            size_t seed;
-            VulkanEngine::HashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.texCord);
-            return seed;
+            return;
+        }
+        // Vertices with minimal and maximal coordinate on each axis
+        size_t minVertex[3]{};
+        size_t maxVertex[3]{};
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const glm::vec3& position = vertices[i].position;
+            bounds.Extend(position);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                minVertex[axis] = position[axis] < vertices[minVertex[axis]].position[axis] ? i : minVertex[axis];
+                maxVertex[axis] = position[axis] > vertices[maxVertex[axis]].position[axis] ? i : maxVertex[axis];
+            }
         }
-    };
-}
 
-namespace VulkanEngine
-{
-    Model::Model(Device& device, const ModelData& builder):
-        device{device}
+        // Start from most distant pair of extremes and grow sphere by every vertex outside of it
+        int widestAxis = 0;
+        float widestDistance = 0.f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float distance = glm::length(vertices[maxVertex[axis]].position - vertices[minVertex[axis]].position);
+            if (distance > widestDistance)
+            {
+                widestAxis = axis;
+                widestDistance = distance;
+            }
+        }
+        sphere.center = (vertices[minVertex[widestAxis]].position + vertices[maxVertex[widestAxis]].position) * 0.5f;
+        sphere.radius = widestDistance * 0.5f;
+        for (const auto& vertex : vertices)
+        {
+            float distance = glm::length(vertex.position - sphere.center);
+            if (distance > sphere.radius)
+            {
+                float radius = (sphere.radius + distance) * 0.5f;
+                sphere.center += (vertex.position - sphere.center) * ((radius - sphere.radius) / distance);
+                sphere.radius = radius;
+            }
+        }
+
+        float boxRadius = glm::length(bounds.GetExtent()) * 0.5f;
+        if (boxRadius < sphere.radius)
+        {
+            sphere = {bounds.GetCenter(), boxRadius};
+        }
+    }
+
+    Model::Model(Device& device, const ModelData& builder, VertexFormat vertexFormat, VertexStreams vertexStreams):
+        device{device},
+        vertexFormat{vertexFormat},
+        vertexStreams{vertexStreams}
     {
-        CreateVertexBuffer(builder.vertices);
-        CreateIndexBuffer(builder.indices);
+        CreateBuffers(builder);
     }
 
-    Model::~Model()
+    Model::Model(Device& device, VertexFormat vertexFormat, VertexStreams vertexStreams):
+        device{device},
+        vertexFormat{vertexFormat},
+        vertexStreams{vertexStreams}
     {
     }
 
-    void Model::CreateVertexBuffer(const std::vector<Vertex>& vertices)
+    std::vector<uint8_t> Model::EncodeVertices(const std::vector<Vertex>& vertices,
+                                               const BoundingBox& meshBounds) const
     {
-        // Calculate vertex data
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount >= 3);
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
+        PROFILE_SCOPE("Model::EncodeVertices");
+        std::vector<uint8_t> encoded(vertices.size() * GetVertexStride(vertexFormat));
+        switch (vertexFormat)
+        {
+        case VertexFormat::Full:
+            std::memcpy(encoded.data(), vertices.data(), encoded.size());
+            break;
+        case VertexFormat::Compact:
+        {
+            auto* compact = reinterpret_cast<CompactVertex*>(encoded.data());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                compact[i].position = QuantizePosition(vertices[i].position, meshBounds);
+                compact[i].normal = EncodeOctahedral(vertices[i].normal);
+                compact[i].texCord = EncodeHalf(vertices[i].texCord);
+            }
+            break;
+        }
+        case VertexFormat::CompactColor:
+        {
+            auto* compact = reinterpret_cast<CompactColorVertex*>(encoded.data());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                compact[i].position = QuantizePosition(vertices[i].position, meshBounds);
+                compact[i].normal = EncodeOctahedral(vertices[i].normal);
+                compact[i].texCord = EncodeHalf(vertices[i].texCord);
+                compact[i].color = EncodeColor(vertices[i].color);
+            }
+            break;
+        }
+        default:
+            throw std::invalid_argument("unknown vertex format!");
+        }
+        return encoded;
+    }
 
-        // Create staging buffer.
-        Buffer stagingBuffer(
-            device,
-            sizeof(vertices[0]),
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::vector<Model::Chunk> Model::SplitChunks(const std::vector<Vertex>& sourceVertices,
+                                                 const std::vector<uint32_t>& sourceIndices,
+                                                 std::vector<Vertex>& vertices, std::vector<uint16_t>& indices)
+    {
+        PROFILE_SCOPE("Model::SplitChunks");
+        std::vector<Chunk> chunks;
+        indices.reserve(indices.size() + sourceIndices.size());
+
+        // Chunk which last used vertex, so nothing has to be cleared when chunk is closed
+        std::vector<uint32_t> vertexChunk(sourceVertices.size(), std::numeric_limits<uint32_t>::max());
+        std::vector<uint16_t> localIndex(sourceVertices.size());
+        Chunk chunk{static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(vertices.size())};
+        uint32_t chunkVertexCount = 0;
+        for (size_t i = 0; i + 2 < sourceIndices.size(); i += 3)
+        {
+            auto chunkIndex = static_cast<uint32_t>(chunks.size());
+            uint32_t newVertices = 0;
+            for (size_t j = i; j < i + 3; j++)
+            {
+                newVertices += vertexChunk[sourceIndices[j]] != chunkIndex ? 1 : 0;
+            }
+            if (chunkVertexCount + newVertices > MAX_CHUNK_VERTICES)
+            {
+                chunks.push_back(chunk);
+                chunk = {static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(vertices.size())};
+                chunkVertexCount = 0;
+                chunkIndex++;
+            }
 
-        stagingBuffer.Map();
-        stagingBuffer.WriteToBuffer((void*)vertices.data(), bufferSize);
+            for (size_t j = i; j < i + 3; j++)
+            {
+                uint32_t index = sourceIndices[j];
+                if (vertexChunk[index] != chunkIndex)
+                {
+                    vertexChunk[index] = chunkIndex;
+                    localIndex[index] = static_cast<uint16_t>(chunkVertexCount++);
+                    vertices.push_back(sourceVertices[index]);
+                }
+                indices.push_back(localIndex[index]);
+            }
+            chunk.indexCount += 3;
+        }
+        if (chunk.indexCount > 0)
+        {
+            chunks.push_back(chunk);
+        }
+        return chunks;
+    }
 
-        // Create vertex buffer.
-        vertexBuffer = std::make_unique<Buffer>(device,
-                                                sizeof(vertices[0]),
-                                                vertexCount,
-                                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    std::vector<std::vector<uint32_t>> Model::BuildLods(const ModelData& data, std::vector<float>& errors)
+    {
+        PROFILE_SCOPE("Model::BuildLods");
+        std::vector<std::vector<uint32_t>> lods{data.indices};
+        errors.assign(1, 0.f);
+        auto vertexCount = static_cast<uint32_t>(data.vertices.size());
+        while (lods.size() < MAX_LODS && lods.back().size() / 3 >= MIN_LOD_TRIANGLES * 2)
+        {
+            const std::vector<uint32_t>& previous = lods.back();
+            // Error of level adds to error of level it is simplified from
+            float error = 0.f;
+            std::vector<uint32_t> simplified = MeshSimplifier::Simplify(data.vertices, previous,
+                                                                        previous.size() / 6 * 3,
+                                                                        MAX_LOD_ERROR - errors.back(), &error);
+            // Level barely smaller than previous one would only take memory
+            if (simplified.size() > previous.size() * 3 / 4)
+            {
+                break;
+            }
+            MeshOptimizer::OptimizeVertexCache(simplified, vertexCount);
+            errors.push_back(errors.back() + error);
+            lods.push_back(std::move(simplified));
+        }
+        return lods;
+    }
+
+    Model::EncodedMesh Model::EncodeMesh(const ModelData& data) const
+    {
+        PROFILE_SCOPE("Model::EncodeMesh");
+        assert(data.vertices.size() >= 3);
+
+        EncodedMesh mesh{};
+        mesh.bounds = data.bounds;
+        mesh.sphere = data.sphere;
+        if (mesh.bounds.IsEmpty())
+        {
+            ComputeVertexBounds(data.vertices, mesh.bounds, mesh.sphere);
+        }
+
+        // Levels of meshes small enough are single chunk each using vertices as they are, levels of bigger
+        // meshes are split into chunks with own copies of vertices
+        const std::vector<Vertex>* sourceVertices = &data.vertices;
+        std::vector<Vertex> chunkVertices;
+        if (!data.indices.empty())
+        {
+            std::vector<float> errors;
+            std::vector<std::vector<uint32_t>> lodIndices = BuildLods(data, errors);
+            bool split = data.vertices.size() > MAX_CHUNK_VERTICES;
+            for (size_t i = 0; i < lodIndices.size(); i++)
+            {
+                Lod lod{static_cast<uint32_t>(mesh.chunks.size()), 0, static_cast<uint32_t>(mesh.meshlets.size()), 0,
+                        errors[i]};
+                if (split)
+                {
+                    std::vector<Chunk> lodChunks = SplitChunks(data.vertices, lodIndices[i], chunkVertices,
+                                                               mesh.indices);
+                    mesh.chunks.insert(mesh.chunks.end(), lodChunks.begin(), lodChunks.end());
+                }
+                else
+                {
+                    mesh.chunks.push_back({static_cast<uint32_t>(mesh.indices.size()),
+                                           static_cast<uint32_t>(lodIndices[i].size()), 0});
+                    mesh.indices.insert(mesh.indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+                }
+                lod.chunkCount = static_cast<uint32_t>(mesh.chunks.size()) - lod.firstChunk;
+                for (uint32_t chunk = lod.firstChunk; chunk < lod.firstChunk + lod.chunkCount; chunk++)
+                {
+                    std::vector<Meshlet> chunkMeshlets = MeshletCuller::Build(split ? chunkVertices : data.vertices,
+                                                                              mesh.indices, mesh.chunks[chunk]);
+                    mesh.meshlets.insert(mesh.meshlets.end(), chunkMeshlets.begin(), chunkMeshlets.end());
+                }
+                lod.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - lod.firstMeshlet;
+                mesh.lods.push_back(lod);
+            }
+            if (split)
+            {
+                sourceVertices = &chunkVertices;
+            }
+        }
+        mesh.vertexCount = static_cast<uint32_t>(sourceVertices->size());
 
-        // Copy staging to vertex.
-        device.CopyBuffer(stagingBuffer.GetBuffer(), vertexBuffer->GetBuffer(), bufferSize);
+        std::vector<uint8_t> vertices = EncodeVertices(*sourceVertices, mesh.bounds);
+        if (vertexStreams != VertexStreams::SplitPositions)
+        {
+            mesh.streams.push_back(std::move(vertices));
+            return mesh;
+        }
+
+        // Position is first member of every format, so streams are just split at its end
+        VkDeviceSize stride = GetVertexStride(vertexFormat);
+        VkDeviceSize positionSize = GetPositionSize(vertexFormat);
+        std::vector<uint8_t> positions(mesh.vertexCount * positionSize);
+        std::vector<uint8_t> attributes(mesh.vertexCount * (stride - positionSize));
+        for (size_t i = 0; i < mesh.vertexCount; i++)
+        {
+            const uint8_t* vertex = vertices.data() + i * stride;
+            std::memcpy(positions.data() + i * positionSize, vertex, positionSize);
+            std::memcpy(attributes.data() + i * (stride - positionSize), vertex + positionSize, stride - positionSize);
+        }
+        mesh.streams.push_back(std::move(positions));
+        mesh.streams.push_back(std::move(attributes));
+        return mesh;
+    }
+
+    void Model::CreateBuffers(const ModelData& data)
+    {
+        PROFILE_SCOPE("Model::CreateBuffers");
+        EncodedMesh mesh = EncodeMesh(data);
+        std::vector<const void*> streamData;
+        for (const auto& stream : mesh.streams)
+        {
+            streamData.push_back(stream.data());
+        }
+        UploadMesh(mesh.bounds, mesh.sphere, mesh.vertexCount, streamData, mesh.indices.data(),
+                   static_cast<uint32_t>(mesh.indices.size()), std::move(mesh.chunks), std::move(mesh.meshlets),
+                   std::move(mesh.lods));
     }
 
-    void Model::CreateIndexBuffer(const std::vector<uint32_t>& indices)
+    void Model::UploadMesh(const BoundingBox& meshBounds, const BoundingSphere& meshSphere, uint32_t vertexCount,
+                           const std::vector<const void*>& streamData, const uint16_t* indices, uint32_t indexCount,
+                           std::vector<Chunk> meshChunks, std::vector<Meshlet> meshMeshlets, std::vector<Lod> meshLods)
     {
-        indexCount = static_cast<uint32_t>(indices.size());
-        hasIndexBuffer = indexCount > 0;
+        bounds = meshBounds;
+        sphere = meshSphere;
+        if (vertexFormat != VertexFormat::Full)
+        {
+            // Must match QuantizePosition, flat axis keeps all positions at minimum
+            glm::vec3 extent = glm::max(bounds.GetExtent(), glm::vec3{std::numeric_limits<float>::min()});
+            dequantizationMatrix = glm::scale(glm::translate(glm::mat4{1.f}, bounds.min), extent);
+        }
+        chunks = std::move(meshChunks);
+        meshlets = std::move(meshMeshlets);
+        lods = std::move(meshLods);
+        memorySize = vertexCount * GetVertexStride(vertexFormat) + indexCount * sizeof(uint16_t);
+
+        // Pool throws before anything is allocated if memory is exhausted
+        GeometryPool& geometryPool = device.GetGeometryPool();
+        geometry = geometryPool.Allocate(GetStreamStrides(vertexFormat, vertexStreams), vertexCount, indexCount,
+                                         VK_INDEX_TYPE_UINT16);
+
+        // Record copy through staging, it is submitted with other uploads.
+        uploadToken = geometryPool.Upload(geometry, streamData, indices);
+    }
 
-        // If no index buffer provided, return
-        if (!hasIndexBuffer)
+    void Model::LoadFromFile()
+    {
+        PROFILE_SCOPE("Model::LoadFromFile");
+        std::string cookedPath = CookedMesh::GetPath(sourcePath, vertexFormat, vertexStreams);
+        std::unique_ptr<CookedMesh> cooked;
+        if (CookedMesh::IsUpToDate(cookedPath, sourcePath, vertexFormat, vertexStreams))
+        {
+            try
+            {
+                cooked = std::make_unique<CookedMesh>(cookedPath);
+            }
+            catch (const std::runtime_error& e)
+            {
+                std::cerr << e.what() << ", cooking it again" << std::endl;
+            }
+        }
+        if (cooked != nullptr)
+        {
+            // Streams and indices are copied from mapped file to staging, nothing is parsed or converted
+            const CookedMesh::Header& header = cooked->GetHeader();
+            std::vector<const void*> streamData;
+            for (uint32_t i = 0; i < GetStreamStrides(vertexFormat, vertexStreams).size(); i++)
+            {
+                streamData.push_back(cooked->GetStream(i));
+            }
+            UploadMesh({header.boundsMin, header.boundsMax}, {header.sphereCenter, header.sphereRadius}, header.vertexCount, streamData, cooked->GetIndices(),
+                       header.indexCount,
+                       std::vector<Chunk>(cooked->GetChunks(), cooked->GetChunks() + header.chunkCount),
+                       std::vector<Meshlet>(cooked->GetMeshlets(), cooked->GetMeshlets() + header.meshletCount),
+                       std::vector<Lod>(cooked->GetLods(), cooked->GetLods() + header.lodCount));
             return;
+        }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
+        ModelData modelData{};
+        modelData.LoadModel(sourcePath);
+        EncodedMesh mesh = EncodeMesh(modelData);
+        try
+        {
+            CookedMesh::Write(cookedPath, sourcePath, vertexFormat, vertexStreams, mesh);
+        }
+        catch (const std::exception& e)
+        {
+            // Model still loads, next launch parses source again
+            std::cerr << "failed to write cooked mesh " << cookedPath << ": " << e.what() << std::endl;
+        }
+
+        std::vector<const void*> streamData;
+        for (const auto& stream : mesh.streams)
+        {
+            streamData.push_back(stream.data());
+        }
+        UploadMesh(mesh.bounds, mesh.sphere, mesh.vertexCount, streamData, mesh.indices.data(),
+                   static_cast<uint32_t>(mesh.indices.size()), std::move(mesh.chunks), std::move(mesh.meshlets),
+                   std::move(mesh.lods));
+    }
 
-        // Create staging buffer
-        Buffer stagingBuffer(
-            device,
-            sizeof(indices[0]),
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VkDeviceSize Model::Evict()
+    {
+        if (!geometry.IsValid())
+        {
+            return 0;
+        }
+        // Memory is released only with last model of page
+        VkDeviceSize released = device.GetGeometryPool().Retire(geometry);
+        // Frames in flight may still draw ranges of model, so they are returned to pool later.
+        device.GetDeletionQueue().Push([geometryPool = &device.GetGeometryPool(), geometry = geometry]() mutable
+        {
+            geometryPool->Free(geometry);
+        });
+        geometry = {};
+        return released;
+    }
 
-        stagingBuffer.Map();
-        stagingBuffer.WriteToBuffer((void*)indices.data(), bufferSize);
+    void Model::Restore()
+    {
+        PROFILE_SCOPE("Model::Restore");
+        LoadFromFile();
+    }
 
-        // Create index buffer
-        indexBuffer = std::make_unique<Buffer>(device,
-                                               sizeof(indices[0]),
-                                               indexCount,
-                                               VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceSize Model::GetMemorySize() const
+    {
+        return memorySize;
+    }
 
-        // Copy staging buffer to index
-        device.CopyBuffer(stagingBuffer.GetBuffer(), indexBuffer->GetBuffer(), bufferSize);
+    uint32_t Model::GetSharedMemoryUserCount() const
+    {
+        return geometry.IsValid() ? device.GetGeometryPool().GetLiveAllocationCount(geometry.page) : 1;
     }
 
+    Model::~Model()
+    {
+        Evict();
+    }
 
     void Model::Bind(VkCommandBuffer commandBuffer)
     {
-        VkBuffer buffers[] = {vertexBuffer->GetBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-        if (hasIndexBuffer)
+        device.GetGeometryPool().Bind(commandBuffer, geometry.page);
+    }
+
+    void Model::BindPositions(VkCommandBuffer commandBuffer)
+    {
+        device.GetGeometryPool().Bind(commandBuffer, geometry.page, 1);
+    }
+
+    uint32_t Model::CullMeshlets(uint32_t lod, const Frustum& frustum, const glm::vec3& cameraPosition,
+                                 std::vector<VkDrawIndexedIndirectCommand>& commands) const
+    {
+        if (lods.empty())
         {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            return 0;
         }
+        const Lod& level = lods[std::min(lod, static_cast<uint32_t>(lods.size() - 1))];
+        return MeshletCuller::Cull(meshlets.data() + level.firstMeshlet, level.meshletCount, frustum, cameraPosition,
+                                   geometry.firstIndex, static_cast<int32_t>(geometry.firstVertex), commands);
     }
 
-    void Model::Draw(VkCommandBuffer commandBuffer)
+    void Model::Draw(VkCommandBuffer commandBuffer, uint32_t lod)
     {
-        if (hasIndexBuffer)
+        // Ranges of model are addressed inside buffers of its page
+        if (lods.empty())
         {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            vkCmdDraw(commandBuffer, geometry.vertexCount, 1, geometry.firstVertex, 0);
+            return;
         }
-        else
+        const Lod& level = lods[std::min(lod, static_cast<uint32_t>(lods.size() - 1))];
+        for (uint32_t i = level.firstChunk; i < level.firstChunk + level.chunkCount; i++)
         {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            const Chunk& chunk = chunks[i];
+            vkCmdDrawIndexed(commandBuffer, chunk.indexCount, 1, geometry.firstIndex + chunk.firstIndex,
+                             static_cast<int32_t>(geometry.firstVertex + chunk.vertexOffset), 0);
         }
     }
 
@@ -145,81 +476,187 @@ namespace VulkanEngine
         return attributeDescriptions;
     }
 
-    std::unique_ptr<Model> Model::CreateModelFromFile(Device& device, const std::string& filepath)
+    static_assert(sizeof(Model::CompactVertex) == 16, "compact vertex must stay 16 bytes");
+    static_assert(sizeof(Model::CompactColorVertex) == 20, "compact color vertex must stay 20 bytes");
+
+    std::vector<VkDeviceSize> Model::GetStreamStrides(VertexFormat format, VertexStreams streams)
+    {
+        std::vector<VkDeviceSize> strides;
+        for (const auto& binding : GetBindingDescriptions(format, streams))
+        {
+            strides.push_back(binding.stride);
+        }
+        return strides;
+    }
+
+    VkDeviceSize Model::GetVertexStride(VertexFormat format)
     {
-        ModelData modelData{};
-        modelData.LoadModel(filepath);
+        switch (format)
+        {
+        case VertexFormat::Full:
+            return sizeof(Vertex);
+        case VertexFormat::Compact:
+            return sizeof(CompactVertex);
+        case VertexFormat::CompactColor:
+            return sizeof(CompactColorVertex);
+        default:
+            throw std::invalid_argument("unknown vertex format!");
+        }
+    }
+
+    VkDeviceSize Model::GetPositionSize(VertexFormat format)
+    {
+        return format == VertexFormat::Full ? sizeof(Vertex::position) : sizeof(CompactVertex::position);
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::GetBindingDescriptions(VertexFormat format,
+                                                                               VertexStreams streams)
+    {
+        VkDeviceSize stride = GetVertexStride(format);
+        if (streams == VertexStreams::SplitPositions)
+        {
+            VkDeviceSize positionSize = GetPositionSize(format);
+            return {
+                {0, static_cast<uint32_t>(positionSize), VK_VERTEX_INPUT_RATE_VERTEX},
+                {1, static_cast<uint32_t>(stride - positionSize), VK_VERTEX_INPUT_RATE_VERTEX}};
+        }
+        return {{0, static_cast<uint32_t>(stride), VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::GetAttributeDescriptions(VertexFormat format,
+                                                                                   VertexStreams streams)
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        switch (format)
+        {
+        case VertexFormat::Full:
+            attributeDescriptions = Vertex::GetAttributeDescriptions();
+            break;
+        case VertexFormat::Compact:
+            attributeDescriptions = CompactVertex::GetAttributeDescriptions();
+            break;
+        case VertexFormat::CompactColor:
+            attributeDescriptions = CompactColorVertex::GetAttributeDescriptions();
+            break;
+        default:
+            throw std::invalid_argument("unknown vertex format!");
+        }
+
+        if (streams == VertexStreams::SplitPositions)
+        {
+            // Everything behind position moves to binding 1
+            auto positionSize = static_cast<uint32_t>(GetPositionSize(format));
+            for (auto& attribute : attributeDescriptions)
+            {
+                if (attribute.location != 0)
+                {
+                    attribute.binding = 1;
+                    attribute.offset -= positionSize;
+                }
+            }
+        }
+        return attributeDescriptions;
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::GetPositionBindingDescriptions(VertexFormat format,
+                                                                                       VertexStreams streams)
+    {
+        // Position stream is binding 0 of both layouts
+        return {GetBindingDescriptions(format, streams)[0]};
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::GetPositionAttributeDescriptions(VertexFormat format)
+    {
+        return {GetAttributeDescriptions(format)[0]};
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::CompactVertex::GetBindingDescription()
+    {
+        return GetBindingDescriptions(VertexFormat::Compact);
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::CompactVertex::GetAttributeDescriptions()
+    {
+        // All formats used for vertex buffers are mandatory, 3 component 16 bit formats are not.
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, texCord)});
 
-        return std::make_unique<Model>(device, modelData);
+        return attributeDescriptions;
     }
 
+    std::vector<VkVertexInputBindingDescription> Model::CompactColorVertex::GetBindingDescription()
+    {
+        return GetBindingDescriptions(VertexFormat::CompactColor);
+    }
 
-    void Model::ModelData::LoadModel(const std::string& filepath)
+    std::vector<VkVertexInputAttributeDescription> Model::CompactColorVertex::GetAttributeDescriptions()
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactColorVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactColorVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactColorVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactColorVertex, texCord)});
+
+        return attributeDescriptions;
+    }
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+    std::unique_ptr<Model> Model::CreateModelFromFile(Device& device, const std::string& filepath,
+                                                      VertexFormat vertexFormat, VertexStreams vertexStreams)
+    {
+        PROFILE_SCOPE("Model::CreateModelFromFile");
+        // Model without buffers, so it can be created even if memory is exhausted
+        std::unique_ptr<Model> model{new Model(device, vertexFormat, vertexStreams)};
+        model->sourcePath = filepath;
+        try
+        {
+            model->LoadFromFile();
+        }
+        catch (const OutOfMemoryError&)
         {
-            throw std::runtime_error(warn + err);
+            // Residency manager restores it once memory is available, memory size is already known.
+            std::cerr << "out of device memory, model " << filepath << " is loaded evicted" << std::endl;
         }
+        return model;
+    }
+
+
+    void Model::ModelData::LoadModel(const std::string& filepath, bool optimize)
+    {
+        PROFILE_SCOPE("Model::ModelData::LoadModel");
+        ObjParser::Mesh mesh = ObjParser::Parse(filepath);
 
         vertices.clear();
         indices.clear();
+        indices.reserve(mesh.indices.size());
 
         // Don't want to duplicate vertices due to performance issue,
         // so store only unique vertices and write proper index
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        vertices.reserve(mesh.positions.size());
+        VertexDeduplicator uniqueVertices{mesh.positions.size()};
 
-        // For each shape in file, load it.
-        for (auto& shape : shapes)
+        for (const auto& index : mesh.indices)
         {
-            // For each index in shape index
-            for (auto& index : shape.mesh.indices)
-            {
-                Vertex vertex{};
+            Vertex vertex{};
+            vertex.position = mesh.positions[index.position];
+            vertex.color = mesh.colors[index.position];
+            vertex.normal = index.normal >= 0 ? mesh.normals[index.normal] : glm::vec3{0.f};
+            vertex.texCord = index.texCord >= 0 ? mesh.texCords[index.texCord] : glm::vec2{0.f};
 
-                // Read vertex data
-                if (index.vertex_index >= 0)
-                {
-                    vertex.position =
-                    {
-                        attrib.vertices[index.vertex_index * 3],
-                        attrib.vertices[index.vertex_index * 3 + 1],
-                        attrib.vertices[index.vertex_index * 3 + 2],
-                    };
-
-                    vertex.color =
-                    {
-                        attrib.colors[index.vertex_index * 3],
-                        attrib.colors[index.vertex_index * 3 + 1],
-                        attrib.colors[index.vertex_index * 3 + 2],
-                    };
-
-                    vertex.normal =
-                    {
-                        attrib.normals[index.normal_index * 3],
-                        attrib.normals[index.normal_index * 3 + 1],
-                        attrib.normals[index.normal_index * 3 + 2],
-                    };
-
-                    vertex.texCord =
-                    {
-                        attrib.texcoords[index.texcoord_index * 2],
-                        attrib.texcoords[index.texcoord_index * 2 + 1],
-                    };
-
-                    if (uniqueVertices.count(vertex) == 0)
-                    {
-                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                        vertices.push_back(vertex);
-                    }
-
-                    indices.push_back(uniqueVertices[vertex]);
-                }
-            }
+            indices.push_back(uniqueVertices.Insert(vertex, vertices));
         }
+
+        // OBJ face order is arbitrary, reorder for vertex cache, overdraw and vertex fetch
+        if (optimize)
+        {
+            MeshOptimizer::Optimize(*this);
+        }
+        ComputeBounds();
+    }
+
+    void Model::ModelData::ComputeBounds()
+    {
+        ComputeVertexBounds(vertices, bounds, sphere);
     }
 }
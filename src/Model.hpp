@@ -1,18 +1,22 @@
 #pragma once
 #include "Device.hpp"
 #include "Buffer.hpp"
+#include "GeometryPool.hpp"
+#include "EvictableResource.hpp"
+#include "Bounds.hpp"
 // Glm
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <memory>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 namespace VulkanEngine
 {
     /// <summary>
     /// Class represent object data in terms of rendering
     /// </summary>
-    class Model
+    class Model : public EvictableResource
     {
     public:
         /// <summary>
@@ -46,59 +50,419 @@ namespace VulkanEngine
             }
         };
 
+        /// <summary>
+        /// Layout of vertices in vertex buffer. Compact formats quantize position relative to model bounds
+        /// (dequantized by model matrix, see GetDequantizationMatrix), encode normal as octahedral
+        /// and texture coordinate as half floats. Every format has its own vertex shader.
+        /// </summary>
+        enum class VertexFormat : uint32_t
+        {
+            // 44 bytes Vertex
+            Full,
+            // 16 bytes CompactVertex, without color
+            Compact,
+            // 20 bytes CompactColorVertex
+            CompactColor,
+            Count
+        };
+
+        /// <summary>
+        /// How vertex attributes are split into vertex buffer bindings.
+        /// </summary>
+        enum class VertexStreams : uint32_t
+        {
+            // All attributes in binding 0
+            Interleaved,
+            // Position in binding 0, other attributes in binding 1, so depth only passes fetch positions only
+            SplitPositions,
+            Count
+        };
+
+        /// <summary>
+        /// Vertex of VertexFormat::Compact.
+        /// </summary>
+        struct CompactVertex
+        {
+            // unorm16 in model bounds, w is padding
+            glm::u16vec4 position;
+            // Octahedral snorm16
+            glm::i16vec2 normal;
+            // Half floats
+            glm::u16vec2 texCord;
+
+            static std::vector<VkVertexInputBindingDescription> GetBindingDescription();
+            static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+        };
+
+        /// <summary>
+        /// Vertex of VertexFormat::CompactColor.
+        /// </summary>
+        struct CompactColorVertex
+        {
+            glm::u16vec4 position;
+            glm::i16vec2 normal;
+            glm::u16vec2 texCord;
+            // unorm8, a is padding
+            glm::u8vec4 color;
+
+            static std::vector<VkVertexInputBindingDescription> GetBindingDescription();
+            static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+        };
+
+        /// <summary>
+        /// Size of one vertex in given format.
+        /// </summary>
+        static VkDeviceSize GetVertexStride(VertexFormat format);
+
+        /// <summary>
+        /// Size of position in given format, position is always first member of vertex.
+        /// </summary>
+        static VkDeviceSize GetPositionSize(VertexFormat format);
+
+        /// <summary>
+        /// Fetch binding descriptions of given format.
+        /// </summary>
+        static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(
+            VertexFormat format, VertexStreams streams = VertexStreams::Interleaved);
+
+        /// <summary>
+        /// Fetch attribute descriptions of given format. Locations are same for all formats:
+        /// 0 position, 1 color, 2 normal, 3 texture coordinate.
+        /// </summary>
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(
+            VertexFormat format, VertexStreams streams = VertexStreams::Interleaved);
+
+        /// <summary>
+        /// Fetch binding descriptions for depth only pipelines, which read position from binding 0 only.
+        /// With split positions it is tightly packed stream, otherwise whole interleaved vertex.
+        /// </summary>
+        static std::vector<VkVertexInputBindingDescription> GetPositionBindingDescriptions(
+            VertexFormat format, VertexStreams streams);
+
+        /// <summary>
+        /// Fetch attribute description of position only, location 0.
+        /// </summary>
+        static std::vector<VkVertexInputAttributeDescription> GetPositionAttributeDescriptions(VertexFormat format);
+
         struct ModelData
         {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            // Set by ComputeBounds, computed from vertices when model is created if left empty
+            BoundingBox bounds{};
+            BoundingSphere sphere{};
+
+            /// <summary>
+            /// Compute bounding box and bounding sphere of vertices.
+            /// </summary>
+            void ComputeBounds();
+
+            /// <summary>
+            /// Load mesh from OBJ file with ObjParser, duplicate vertices are merged and bounds are computed.
+            /// </summary>
+            /// <param name="filepath"> Path to model data</param>
+            /// <param name="optimize"> Reorder triangles and vertices with MeshOptimizer</param>
+            void LoadModel(const std::string& filepath, bool optimize = true);
+        };
+
+        // Index buffers are 16 bit, meshes with more vertices are split into chunks
+        static constexpr uint32_t MAX_CHUNK_VERTICES = 65536;
+
+        /// <summary>
+        /// Part of mesh drawn with own vertex offset, so its indices fit into 16 bits.
+        /// Ranges are relative to geometry of model.
+        /// </summary>
+        struct Chunk
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            uint32_t vertexOffset = 0;
+        };
+
+        // Meshlets are culled on CPU, they are small enough to skip parts of mesh and big enough to keep draws few
+        static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+        static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+        /// <summary>
+        /// Cluster of consecutive triangles of one chunk with bounds in model space, see MeshletCuller.
+        /// </summary>
+        struct Meshlet
+        {
+            glm::vec3 center{};
+            float radius = 0.f;
+            // Normals of all triangles are within cone around axis
+            glm::vec3 coneAxis{};
+            // Sine of cone angle, meshlet faces away from camera if it sees sphere within this angle of axis.
+            // 1 disables cone culling.
+            float coneCutoff = 1.f;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            uint32_t vertexOffset = 0;
+            uint32_t reserved = 0;
+        };
+
+        // LOD 0 is full mesh, each next level targets half of triangles of previous one
+        static constexpr uint32_t MAX_LODS = 5;
+        // Meshes and levels with fewer triangles are not simplified further
+        static constexpr uint32_t MIN_LOD_TRIANGLES = 64;
+        // Simplification stops at this error relative to mesh extent
+        static constexpr float MAX_LOD_ERROR = 0.05f;
+
+        /// <summary>
+        /// Level of detail as consecutive range of chunks and their meshlets, LOD 0 is full mesh.
+        /// </summary>
+        struct Lod
+        {
+            uint32_t firstChunk = 0;
+            uint32_t chunkCount = 0;
+            uint32_t firstMeshlet = 0;
+            uint32_t meshletCount = 0;
+            // Simplification error relative to mesh extent, 0 for LOD 0
+            float error = 0.f;
+        };
 
-            void LoadModel(const std::string& filepath);
+        /// <summary>
+        /// Mesh in layout of geometry pool buffers: encoded vertex streams, 16 bit indices, their chunks and
+        /// meshlets and levels of detail made of chunks.
+        /// </summary>
+        struct EncodedMesh
+        {
+            BoundingBox bounds;
+            BoundingSphere sphere;
+            uint32_t vertexCount = 0;
+            // Bytes of each vertex stream
+            std::vector<std::vector<uint8_t>> streams;
+            std::vector<uint16_t> indices;
+            std::vector<Chunk> chunks;
+            std::vector<Meshlet> meshlets;
+            std::vector<Lod> lods;
         };
 
-        Model(Device& device, const ModelData& builder);
+        /// <summary>
+        /// Size of one vertex in each stream of given layout.
+        /// </summary>
+        static std::vector<VkDeviceSize> GetStreamStrides(VertexFormat format, VertexStreams streams);
+
+        Model(Device& device, const ModelData& builder, VertexFormat vertexFormat = VertexFormat::Full,
+              VertexStreams vertexStreams = VertexStreams::Interleaved);
         ~Model();
         Model(const Model&) = delete;
         Model& operator=(const Model&) = delete;
 
         /// <summary>
-        /// Load model from file using tiny_obj_loader and create model object
+        /// Load model from OBJ file using ObjParser and create model object. Model remembers file,
+        /// so it can be evicted. If device memory is exhausted, model is created evicted.
+        /// Mesh is cooked into CookedMesh file next to OBJ file, which is loaded instead while it is up to date.
+        /// Each call creates new model, AssetRegistry::LoadModel shares loaded models.
         /// </summary>
         /// <param name="device"> Current device</param>
         /// <param name="filepath"> Path to model data</param>
+        /// <param name="vertexFormat"> Layout of vertices in vertex buffer</param>
+        /// <param name="vertexStreams"> Bindings attributes are split into</param>
         /// <returns>unique_ptr<Model> created model</returns>
-        static std::unique_ptr<Model> CreateModelFromFile(Device& device, const std::string& filepath);
+        static std::unique_ptr<Model> CreateModelFromFile(Device& device, const std::string& filepath,
+                                                          VertexFormat vertexFormat = VertexFormat::Full,
+                                                          VertexStreams vertexStreams = VertexStreams::Interleaved);
+
+        bool CanEvict() const override
+        {
+            return !sourcePath.empty();
+        }
+
+        bool IsResident() const override
+        {
+            return geometry.IsValid();
+        }
+
+        VkDeviceSize Evict() override;
+        void Restore() override;
+        VkDeviceSize GetMemorySize() const override;
+
+        UploadToken GetUploadToken() const override
+        {
+            return uploadToken;
+        }
+
+        VertexFormat GetVertexFormat() const
+        {
+            return vertexFormat;
+        }
+
+        VertexStreams GetVertexStreams() const
+        {
+            return vertexStreams;
+        }
+
+        const BoundingBox& GetBounds() const
+        {
+            return bounds;
+        }
+
+        const BoundingSphere& GetBoundingSphere() const
+        {
+            return sphere;
+        }
+
+        /// <summary>
+        /// Matrix transforming positions of vertex buffer to model space, it has to be applied before
+        /// model matrix. Identity for VertexFormat::Full.
+        /// </summary>
+        const glm::mat4& GetDequantizationMatrix() const
+        {
+            return dequantizationMatrix;
+        }
+
+        /// <summary>
+        /// Models share memory of their geometry pool page.
+        /// </summary>
+        uint64_t GetSharedMemoryKey() const override
+        {
+            return geometry.IsValid() ? geometry.page + 1ull : 0;
+        }
+
+        uint32_t GetSharedMemoryUserCount() const override;
+
+        /// <summary>
+        /// Page of geometry pool holding vertices and indices of model. Models of same page
+        /// can be drawn after single bind.
+        /// </summary>
+        uint32_t GetPage() const
+        {
+            return geometry.page;
+        }
 
         /// <summary>
-        /// Bind model to commandBuffer
+        /// Bind buffers of model's geometry pool page to commandBuffer
         /// </summary>
         /// <param name="commandBuffer"> Current command buffer</param>
         void Bind(VkCommandBuffer commandBuffer);
 
         /// <summary>
-        /// Record draw to commandBuffer
+        /// Bind only binding 0, which holds positions, for depth only pipelines.
         /// </summary>
         /// <param name="commandBuffer"> Current command buffer</param>
-        void Draw(VkCommandBuffer commandBuffer);
+        void BindPositions(VkCommandBuffer commandBuffer);
+
+        /// <summary>
+        /// Number of levels of detail, 0 for models without indices.
+        /// </summary>
+        uint32_t GetLodCount() const
+        {
+            return static_cast<uint32_t>(lods.size());
+        }
+
+        /// <summary>
+        /// Simplification error of level relative to extent of model bounds.
+        /// </summary>
+        float GetLodError(uint32_t lod) const
+        {
+            return lods[lod].error;
+        }
+
+        /// <summary>
+        /// Cull meshlets of level with MeshletCuller and append draws of visible ones, ranges are addressed
+        /// inside buffers of page of model.
+        /// </summary>
+        /// <param name="lod"> Level of detail, clamped to last level</param>
+        /// <param name="frustum"> View frustum in model space</param>
+        /// <param name="cameraPosition"> Camera position in model space</param>
+        /// <param name="commands"> Draws of visible index ranges</param>
+        /// <returns> Number of visible meshlets</returns>
+        uint32_t CullMeshlets(uint32_t lod, const Frustum& frustum, const glm::vec3& cameraPosition,
+                              std::vector<VkDrawIndexedIndirectCommand>& commands) const;
+
+        /// <summary>
+        /// Record draw to commandBuffer, one draw per chunk of level, page of model must be bound
+        /// </summary>
+        /// <param name="commandBuffer"> Current command buffer</param>
+        /// <param name="lod"> Level of detail, clamped to last level</param>
+        void Draw(VkCommandBuffer commandBuffer, uint32_t lod = 0);
 
     private:
         /// <summary>
-        /// Create vertex buffer.
+        /// Create model without buffers.
+        /// </summary>
+        Model(Device& device, VertexFormat vertexFormat, VertexStreams vertexStreams);
+
+        /// <summary>
+        /// Convert vertices to vertex format of model.
+        /// </summary>
+        /// <param name="vertices"> Vertices in full format</param>
+        /// <param name="meshBounds"> Bounds of all vertices, compact formats quantize positions relative to them</param>
+        /// <returns> Bytes of vertex buffer</returns>
+        std::vector<uint8_t> EncodeVertices(const std::vector<Vertex>& vertices, const BoundingBox& meshBounds) const;
+
+        /// <summary>
+        /// Convert mesh to vertex format, vertex streams, chunks and levels of detail of model.
+        /// </summary>
+        EncodedMesh EncodeMesh(const ModelData& data) const;
+
+        /// <summary>
+        /// Simplify mesh with MeshSimplifier into up to MAX_LODS levels, each from previous one.
+        /// Building stops once level doesn't reduce triangles enough or error gets over MAX_LOD_ERROR.
+        /// </summary>
+        /// <param name="data"> Indexed triangle list, its indices are LOD 0</param>
+        /// <param name="errors"> Error of each level relative to mesh extent</param>
+        /// <returns> Indices of each level</returns>
+        static std::vector<std::vector<uint32_t>> BuildLods(const ModelData& data, std::vector<float>& errors);
+
+        /// <summary>
+        /// Split triangles into chunks referencing at most MAX_CHUNK_VERTICES vertices each. Vertices shared by
+        /// chunks are duplicated, vertices of each chunk are consecutive and indices are local to chunk.
+        /// </summary>
+        /// <param name="sourceVertices"> Vertices indexed by sourceIndices</param>
+        /// <param name="sourceIndices"> Triangle list</param>
+        /// <param name="vertices"> Vertices of all chunks, vertices of new chunks are appended</param>
+        /// <param name="indices"> 16 bit indices of all chunks, indices of new chunks are appended</param>
+        /// <returns> New chunks in order of their indices</returns>
+        static std::vector<Chunk> SplitChunks(const std::vector<Vertex>& sourceVertices,
+                                              const std::vector<uint32_t>& sourceIndices,
+                                              std::vector<Vertex>& vertices, std::vector<uint16_t>& indices);
+
+        /// <summary>
+        /// Allocate geometry in pool and upload data, nothing is left allocated if device memory is exhausted.
+        /// </summary>
+        void CreateBuffers(const ModelData& data);
+
+        /// <summary>
+        /// Allocate geometry in pool and record upload of already encoded data, which is copied straight
+        /// into staging. Memory size is set even if device memory is exhausted.
         /// </summary>
-        /// <param name="vertices"> Vertices to be write to vertex buffer</param>
-        void CreateVertexBuffer(const std::vector<Vertex>& vertices);
+        /// <param name="meshBounds"> Bounds of mesh, positions of compact formats are quantized in them</param>
+        /// <param name="meshSphere"> Bounding sphere of mesh</param>
+        /// <param name="vertexCount"> Number of vertices in every stream</param>
+        /// <param name="streamData"> Bytes of each vertex stream</param>
+        /// <param name="indices"> 16 bit indices</param>
+        /// <param name="indexCount"> Number of indices</param>
+        /// <param name="meshChunks"> Chunks of indices</param>
+        /// <param name="meshMeshlets"> Meshlets of chunks</param>
+        /// <param name="meshLods"> Levels of detail made of chunks</param>
+        void UploadMesh(const BoundingBox& meshBounds, const BoundingSphere& meshSphere, uint32_t vertexCount, const std::vector<const void*>& streamData,
+                        const uint16_t* indices, uint32_t indexCount, std::vector<Chunk> meshChunks,
+                        std::vector<Meshlet> meshMeshlets, std::vector<Lod> meshLods);
 
         /// <summary>
-        /// Create index buffer.
+        /// Load geometry from cooked mesh of source file if it is up to date, otherwise parse source and cook it.
         /// </summary>
-        /// <param name="indices">Indices to be write to index buffer</param>
-        void CreateIndexBuffer(const std::vector<uint32_t>& indices);
+        void LoadFromFile();
 
         Device& device;
+        // File model was loaded from, empty if model was created from data
+        std::string sourcePath;
+        UploadToken uploadToken = 0;
+        VkDeviceSize memorySize = 0;
 
-        std::unique_ptr<Buffer> vertexBuffer;
-        uint32_t vertexCount;
+        VertexFormat vertexFormat;
+        VertexStreams vertexStreams;
+        BoundingBox bounds;
+        BoundingSphere sphere;
+        glm::mat4 dequantizationMatrix{1.f};
 
-        bool hasIndexBuffer = false;
-        std::unique_ptr<Buffer> indexBuffer;
-        uint32_t indexCount;
+        // Vertex and index ranges in geometry pool, invalid while evicted
+        GeometryPool::Allocation geometry;
+        // Empty for models without indices
+        std::vector<Chunk> chunks;
+        std::vector<Meshlet> meshlets;
+        std::vector<Lod> lods;
     };
 }
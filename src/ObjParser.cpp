@@ -0,0 +1,396 @@
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    // Corner of chunk, relative indices are counted from first attribute of chunk until chunks are merged.
+    struct ChunkIndex
+    {
+        ObjParser::Index index;
+        // Bit 0 position, bit 1 texture coordinate, bit 2 normal
+        uint32_t relative = 0;
+    };
+
+    struct ObjChunk
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> colors;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCords;
+        std::vector<ChunkIndex> indices;
+    };
+
+    static bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    static const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+        {
+            p++;
+        }
+        return p;
+    }
+
+    static bool IsLineEnd(const char* p, const char* end)
+    {
+        return p >= end || *p == '\r' || *p == '#';
+    }
+
+    static double PowerOf10(int exponent)
+    {
+        // Exact in double up to 10^22
+        static constexpr double POWERS[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return exponent < 23 ? POWERS[exponent] : std::pow(10.0, exponent);
+    }
+
+    // Parse decimal float without locale and allocations, digits beyond 19 significant ones are ignored.
+    // Values which don't fit float, e.g. 1e400, are rejected like malformed numbers.
+    static const char* ParseFloat(const char* p, const char* end, float& value)
+    {
+        p = SkipSpaces(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+
+        const char* start = p;
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        for (; p < end && IsDigit(*p); p++)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digits += mantissa > 0 ? 1 : 0;
+            }
+            else
+            {
+                exponent++;
+            }
+        }
+        if (p < end && *p == '.')
+        {
+            for (p++; p < end && IsDigit(*p); p++)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    digits += mantissa > 0 ? 1 : 0;
+                    exponent--;
+                }
+            }
+        }
+        if (p == start)
+        {
+            throw std::runtime_error("failed to parse obj number!");
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+            {
+                negativeExponent = *p == '-';
+                p++;
+            }
+            int explicitExponent = 0;
+            for (; p < end && IsDigit(*p); p++)
+            {
+                explicitExponent = std::min(explicitExponent * 10 + (*p - '0'), 1000);
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+
+        auto result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / PowerOf10(-exponent) : result * PowerOf10(exponent);
+        // Also false for NaN, e.g. 0e400 multiplies 0 by infinity
+        if (!(std::abs(result) <= std::numeric_limits<float>::max()))
+        {
+            throw std::runtime_error("failed to parse obj number!");
+        }
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
+    // Parse index in range of int32_t, bigger values are rejected instead of wrapping.
+    static const char* ParseInt(const char* p, const char* end, int64_t& value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !IsDigit(*p))
+        {
+            throw std::runtime_error("failed to parse obj face!");
+        }
+        value = 0;
+        for (; p < end && IsDigit(*p); p++)
+        {
+            value = value * 10 + (*p - '0');
+            if (value > static_cast<int64_t>(std::numeric_limits<int32_t>::max()) + 1)
+            {
+                throw std::runtime_error("failed to parse obj face!");
+            }
+        }
+        value = negative ? -value : value;
+        if (value > std::numeric_limits<int32_t>::max())
+        {
+            throw std::runtime_error("failed to parse obj face!");
+        }
+        return p;
+    }
+
+    // Convert 1 based OBJ index, negative ones are relative to attributes read so far in chunk.
+    static int32_t ResolveIndex(int64_t value, size_t count, uint32_t bit, uint32_t& relative)
+    {
+        if (value > 0)
+        {
+            return static_cast<int32_t>(value - 1);
+        }
+        if (value < 0)
+        {
+            relative |= bit;
+            return static_cast<int32_t>(static_cast<int64_t>(count) + value);
+        }
+        throw std::runtime_error("failed to parse obj face, index 0 is invalid!");
+    }
+
+    static void ParseFace(const char* p, const char* end, ObjChunk& chunk, std::vector<ChunkIndex>& polygon)
+    {
+        polygon.clear();
+        while (true)
+        {
+            p = SkipSpaces(p, end);
+            if (IsLineEnd(p, end))
+            {
+                break;
+            }
+
+            // v, v/vt, v//vn or v/vt/vn
+            ChunkIndex corner{};
+            int64_t value;
+            p = ParseInt(p, end, value);
+            corner.index.position = ResolveIndex(value, chunk.positions.size(), 1, corner.relative);
+            if (p < end && *p == '/')
+            {
+                p++;
+                if (p < end && *p != '/')
+                {
+                    p = ParseInt(p, end, value);
+                    corner.index.texCord = ResolveIndex(value, chunk.texCords.size(), 2, corner.relative);
+                }
+                if (p < end && *p == '/')
+                {
+                    p++;
+                    p = ParseInt(p, end, value);
+                    corner.index.normal = ResolveIndex(value, chunk.normals.size(), 4, corner.relative);
+                }
+            }
+            polygon.push_back(corner);
+        }
+
+        for (size_t i = 2; i < polygon.size(); i++)
+        {
+            chunk.indices.push_back(polygon[0]);
+            chunk.indices.push_back(polygon[i - 1]);
+            chunk.indices.push_back(polygon[i]);
+        }
+    }
+
+    static void ParseChunk(const char* p, const char* end, ObjChunk& chunk)
+    {
+        std::vector<ChunkIndex> polygon;
+        while (p < end)
+        {
+            auto* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (lineEnd == nullptr)
+            {
+                lineEnd = end;
+            }
+
+            p = SkipSpaces(p, lineEnd);
+            if (lineEnd - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                // x y z, x y z w or x y z r g b, w is ignored
+                float values[6];
+                uint32_t count = 0;
+                for (p++; !IsLineEnd(SkipSpaces(p, lineEnd), lineEnd); count++)
+                {
+                    if (count == 6)
+                    {
+                        throw std::runtime_error("failed to parse obj vertex!");
+                    }
+                    p = ParseFloat(p, lineEnd, values[count]);
+                }
+                if (count != 3 && count != 4 && count != 6)
+                {
+                    throw std::runtime_error("failed to parse obj vertex!");
+                }
+                chunk.positions.emplace_back(values[0], values[1], values[2]);
+                chunk.colors.push_back(count == 6 ? glm::vec3{values[3], values[4], values[5]} : glm::vec3{1.f});
+            }
+            else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                glm::vec2 texCord;
+                p = ParseFloat(p + 2, lineEnd, texCord.x);
+                ParseFloat(p, lineEnd, texCord.y);
+                chunk.texCords.push_back(texCord);
+            }
+            else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                glm::vec3 normal;
+                p = ParseFloat(p + 2, lineEnd, normal.x);
+                p = ParseFloat(p, lineEnd, normal.y);
+                ParseFloat(p, lineEnd, normal.z);
+                chunk.normals.push_back(normal);
+            }
+            else if (lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                ParseFace(p + 1, lineEnd, chunk, polygon);
+            }
+            // Last line may have no newline
+            p = lineEnd < end ? lineEnd + 1 : end;
+        }
+    }
+
+    // Run task for each index on own thread, first exception is rethrown after all threads finish.
+    static void RunParallel(size_t taskCount, const std::function<void(size_t)>& task)
+    {
+        std::vector<std::exception_ptr> errors(taskCount);
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < taskCount; i++)
+        {
+            threads.emplace_back([&task, &errors, i]()
+            {
+                try
+                {
+                    task(i);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        try
+        {
+            task(0);
+        }
+        catch (...)
+        {
+            errors[0] = std::current_exception();
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (auto& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    ObjParser::Mesh ObjParser::Parse(const std::string& filepath, uint32_t threadCount)
+    {
+        PROFILE_SCOPE("ObjParser::Parse");
+        MappedFile file{filepath};
+        return Parse(file.GetData(), file.GetSize(), threadCount);
+    }
+
+    ObjParser::Mesh ObjParser::Parse(const char* data, size_t size, uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, threadCount);
+
+        // Chunks start at beginning of line following their even split point
+        std::vector<const char*> boundaries(chunkCount + 1, data + size);
+        boundaries[0] = data;
+        for (size_t i = 1; i < chunkCount; i++)
+        {
+            const char* split = std::max(data + size * i / chunkCount, boundaries[i - 1]);
+            auto* lineEnd = static_cast<const char*>(std::memchr(split, '\n', static_cast<size_t>(data + size - split)));
+            boundaries[i] = lineEnd != nullptr ? lineEnd + 1 : data + size;
+        }
+
+        std::vector<ObjChunk> chunks(chunkCount);
+        RunParallel(chunkCount, [&](size_t i)
+        {
+            ParseChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+        });
+
+        // Offsets of chunks in merged attributes
+        std::vector<size_t> positionOffsets(chunkCount + 1, 0);
+        std::vector<size_t> normalOffsets(chunkCount + 1, 0);
+        std::vector<size_t> texCordOffsets(chunkCount + 1, 0);
+        std::vector<size_t> indexOffsets(chunkCount + 1, 0);
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size();
+            normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+            texCordOffsets[i + 1] = texCordOffsets[i] + chunks[i].texCords.size();
+            indexOffsets[i + 1] = indexOffsets[i] + chunks[i].indices.size();
+        }
+
+        Mesh mesh{};
+        mesh.positions.resize(positionOffsets[chunkCount]);
+        mesh.colors.resize(positionOffsets[chunkCount]);
+        mesh.normals.resize(normalOffsets[chunkCount]);
+        mesh.texCords.resize(texCordOffsets[chunkCount]);
+        mesh.indices.resize(indexOffsets[chunkCount]);
+        auto positionCount = static_cast<int64_t>(mesh.positions.size());
+        auto normalCount = static_cast<int64_t>(mesh.normals.size());
+        auto texCordCount = static_cast<int64_t>(mesh.texCords.size());
+
+        RunParallel(chunkCount, [&](size_t i)
+        {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + positionOffsets[i]);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), mesh.colors.begin() + positionOffsets[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), mesh.normals.begin() + normalOffsets[i]);
+            std::copy(chunk.texCords.begin(), chunk.texCords.end(), mesh.texCords.begin() + texCordOffsets[i]);
+
+            Index* output = mesh.indices.data() + indexOffsets[i];
+            for (const auto& corner : chunk.indices)
+            {
+                Index index = corner.index;
+                index.position += (corner.relative & 1) != 0 ? static_cast<int32_t>(positionOffsets[i]) : 0;
+                index.texCord += (corner.relative & 2) != 0 ? static_cast<int32_t>(texCordOffsets[i]) : 0;
+                index.normal += (corner.relative & 4) != 0 ? static_cast<int32_t>(normalOffsets[i]) : 0;
+                if (index.position < 0 || index.position >= positionCount || index.texCord < -1 ||
+                    index.texCord >= texCordCount || index.normal < -1 || index.normal >= normalCount)
+                {
+                    throw std::runtime_error("failed to parse obj face, index is out of range!");
+                }
+                *output++ = index;
+            }
+        });
+        return mesh;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Wavefront OBJ parser. File is memory mapped and split into line aligned chunks parsed in parallel,
+    /// chunks are merged once all of them are parsed. Only geometry is read (v, vt, vn and f), polygons are
+    /// triangulated as fans, everything else (groups, materials, smoothing) is skipped.
+    /// </summary>
+    class ObjParser
+    {
+    public:
+        // Smaller files are parsed by fewer threads, so each has enough work to pay for starting it
+        static constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+        /// <summary>
+        /// Attribute indices of one triangle corner, 0 based, -1 if corner doesn't reference attribute.
+        /// </summary>
+        struct Index
+        {
+            int32_t position = -1;
+            int32_t texCord = -1;
+            int32_t normal = -1;
+        };
+
+        struct Mesh
+        {
+            std::vector<glm::vec3> positions;
+            // Vertex colors following position, 1 if file has none
+            std::vector<glm::vec3> colors;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec2> texCords;
+            // Three corners per triangle
+            std::vector<Index> indices;
+        };
+
+        /// <summary>
+        /// Parse OBJ file.
+        /// </summary>
+        /// <param name="filepath"> Path to OBJ file</param>
+        /// <param name="threadCount"> Maximal number of parsing threads, 0 for hardware concurrency</param>
+        /// <returns> Parsed mesh with indices resolved to whole file</returns>
+        /// <exception cref="std::runtime_error"> File can't be read or is malformed</exception>
+        static Mesh Parse(const std::string& filepath, uint32_t threadCount = 0);
+
+        /// <summary>
+        /// Parse OBJ from memory.
+        /// </summary>
+        /// <param name="data"> Contents of OBJ file</param>
+        /// <param name="size"> Size of contents</param>
+        /// <param name="threadCount"> Maximal number of parsing threads, 0 for hardware concurrency</param>
+        /// <returns> Parsed mesh with indices resolved to whole file</returns>
+        static Mesh Parse(const char* data, size_t size, uint32_t threadCount = 0);
+    };
+}
@@ -7,13 +7,25 @@ namespace VulkanEngine
     struct FrameBufferAttachment
     {
         VkImage image;
-        VkDeviceMemory mem;
+        MemoryAllocation mem;
         VkImageView view;
     };
+
+    /// <summary>
+    /// Render target with own color and depth attachments, used instead of swap chain images.
+    /// </summary>
     class OffscreenRenderer
     {
     public:
-        OffscreenRenderer(Device& device, int width, int height, VkFormat depthFormat);
+        /// <summary>
+        /// Create attachments, render pass and framebuffer.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="width"> Width of attachments</param>
+        /// <param name="height"> Height of attachments</param>
+        /// <param name="colorFormat"> Format of color attachment</param>
+        /// <param name="depthFormat"> Format of depth attachment</param>
+        OffscreenRenderer(Device& device, int width, int height, VkFormat colorFormat, VkFormat depthFormat);
         ~OffscreenRenderer();
 
         OffscreenRenderer(const OffscreenRenderer&) = delete;
@@ -24,18 +36,38 @@ namespace VulkanEngine
             return renderPass;
         }
 
+        VkFramebuffer GetFramebuffer()
+        {
+            return framebuffer;
+        }
+
+        VkExtent2D GetExtent() const
+        {
+            return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        }
+
+        const FrameBufferAttachment& GetColorAttachment() const
+        {
+            return colorAttachment;
+        }
+
+        const FrameBufferAttachment& GetDepthAttachment() const
+        {
+            return depthAttachment;
+        }
+
     private:
         void CreateRenderPass();
         void CreateFramebuffer();
 
+        Device& device;
         const int width;
         const int height;
-        Device& device;
         VkRenderPass renderPass;
         FrameBufferAttachment colorAttachment;
         FrameBufferAttachment depthAttachment;
         VkFramebuffer framebuffer;
+        VkFormat colorFormat;
         VkFormat depthFormat;
-
     };
 }
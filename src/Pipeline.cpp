@@ -5,6 +5,7 @@
 #include <ios>
 
 #include "Model.hpp"
+#include "Profiler.hpp"
 
 namespace VulkanEngine
 {
@@ -30,6 +31,7 @@ namespace VulkanEngine
     void Pipeline::CreateGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,
                                           const PipelineConfigInfo& configInfo)
     {
+        PROFILE_SCOPE("Pipeline::CreateGraphicsPipeline");
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE);
         assert(configInfo.renderPass != VK_NULL_HANDLE);
 
@@ -205,10 +207,15 @@ namespace VulkanEngine
 
     Pipeline::~Pipeline()
     {
-        vkDestroyShaderModule(device.GetDevice(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(device.GetDevice(), fragShaderModule, nullptr);
-
-        vkDestroyPipeline(device.GetDevice(), graphicsPipeline, nullptr);
+        // Frames in flight may still be bound to pipeline
+        device.GetDeletionQueue().Push(
+            [device = device.GetDevice(), vertShaderModule = vertShaderModule, fragShaderModule = fragShaderModule,
+                graphicsPipeline = graphicsPipeline]()
+            {
+                vkDestroyShaderModule(device, vertShaderModule, nullptr);
+                vkDestroyShaderModule(device, fragShaderModule, nullptr);
+                vkDestroyPipeline(device, graphicsPipeline, nullptr);
+            });
     }
 
     void Pipeline::Bind(VkCommandBuffer commandBuffer)
@@ -0,0 +1,157 @@
+#include "Profiler.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace VulkanEngine
+{
+    namespace
+    {
+        struct ProfileEvent
+        {
+            const char* name;
+            int64_t startNs;
+            int64_t durationNs;
+        };
+
+        // Events are appended only by owning thread. Count is published after event is written,
+        // so exporting thread sees only complete events.
+        struct EventChunk
+        {
+            static constexpr uint32_t CAPACITY = 4096;
+
+            std::array<ProfileEvent, CAPACITY> events;
+            std::atomic<uint32_t> count{0};
+            std::atomic<EventChunk*> next{nullptr};
+        };
+
+        struct ThreadBuffer
+        {
+            uint32_t threadId;
+            std::vector<std::unique_ptr<EventChunk>> chunks;
+            std::atomic<EventChunk*> first{nullptr};
+            EventChunk* current = nullptr;
+        };
+
+        // Buffers live until program ends, so zones of finished threads can still be exported.
+        struct ThreadRegistry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        };
+
+        ThreadRegistry& GetRegistry()
+        {
+            static ThreadRegistry registry;
+            return registry;
+        }
+
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+        // Lock is taken only once per thread, when it records first zone.
+        ThreadBuffer& GetThreadBuffer()
+        {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer == nullptr)
+            {
+                auto& registry = GetRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                auto newBuffer = std::make_unique<ThreadBuffer>();
+                newBuffer->threadId = static_cast<uint32_t>(registry.buffers.size());
+                buffer = newBuffer.get();
+                registry.buffers.push_back(std::move(newBuffer));
+            }
+            return *buffer;
+        }
+
+        void WriteEscaped(std::ostream& out, const char* text)
+        {
+            for (; *text != '\0'; text++)
+            {
+                if (*text == '"' || *text == '\\')
+                {
+                    out << '\\';
+                }
+                out << *text;
+            }
+        }
+    }
+
+    int64_t Profiler::Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    void Profiler::Record(const char* name, int64_t startNs, int64_t endNs)
+    {
+        auto& buffer = GetThreadBuffer();
+        if (buffer.current == nullptr ||
+            buffer.current->count.load(std::memory_order_relaxed) == EventChunk::CAPACITY)
+        {
+            buffer.chunks.push_back(std::make_unique<EventChunk>());
+            EventChunk* chunk = buffer.chunks.back().get();
+            if (buffer.current == nullptr)
+            {
+                buffer.first.store(chunk, std::memory_order_release);
+            }
+            else
+            {
+                buffer.current->next.store(chunk, std::memory_order_release);
+            }
+            buffer.current = chunk;
+        }
+
+        EventChunk* chunk = buffer.current;
+        uint32_t index = chunk->count.load(std::memory_order_relaxed);
+        chunk->events[index] = {name, startNs, endNs - startNs};
+        chunk->count.store(index + 1, std::memory_order_release);
+    }
+
+    void Profiler::WriteChromeTrace(const std::string& filepath)
+    {
+        std::ofstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file " + filepath);
+        }
+
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        // Chrome trace expects microseconds.
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool firstEvent = true;
+        for (auto& buffer : registry.buffers)
+        {
+            file << (firstEvent ? "\n" : ",\n");
+            firstEvent = false;
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"thread " << buffer->threadId << "\"}}";
+
+            for (EventChunk* chunk = buffer->first.load(std::memory_order_acquire); chunk != nullptr;
+                 chunk = chunk->next.load(std::memory_order_acquire))
+            {
+                uint32_t count = chunk->count.load(std::memory_order_acquire);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const ProfileEvent& event = chunk->events[i];
+                    file << ",\n{\"name\":\"";
+                    WriteEscaped(file, event.name);
+                    file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                        << ",\"ts\":" << static_cast<double>(event.startNs) / 1000.0
+                        << ",\"dur\":" << static_cast<double>(event.durationNs) / 1000.0 << "}";
+                }
+            }
+        }
+        file << "\n]}\n";
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Profiler zones exist only in debug builds, release builds compile them out completely.
+#ifndef NDEBUG
+#define VULKAN_ENGINE_PROFILER_ENABLED
+#endif
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// CPU profiler collecting timed zones. Each thread records into its own buffer without locking,
+    /// zones can be exported to Chrome trace format (chrome://tracing, ui.perfetto.dev).
+    /// </summary>
+    class Profiler
+    {
+    public:
+        /// <summary>
+        /// Get current profiler time.
+        /// </summary>
+        /// <returns> Nanoseconds since profiler start</returns>
+        static int64_t Now();
+
+        /// <summary>
+        /// Record finished zone in buffer of calling thread.
+        /// </summary>
+        /// <param name="name"> Zone name, must outlive profiler (string literal)</param>
+        /// <param name="startNs"> Zone start, see Now()</param>
+        /// <param name="endNs"> Zone end, see Now()</param>
+        static void Record(const char* name, int64_t startNs, int64_t endNs);
+
+        /// <summary>
+        /// Write all recorded zones as Chrome trace JSON.
+        /// Should be called when no other thread records zones.
+        /// </summary>
+        /// <param name="filepath"> Path of output file</param>
+        static void WriteChromeTrace(const std::string& filepath);
+
+        static constexpr bool IsEnabled()
+        {
+#ifdef VULKAN_ENGINE_PROFILER_ENABLED
+            return true;
+#else
+            return false;
+#endif
+        }
+    };
+
+    /// <summary>
+    /// Zone measuring time from construction to end of scope.
+    /// </summary>
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name):
+            name(name),
+            start(Profiler::Now())
+        {
+        }
+
+        ~ProfileScope()
+        {
+            Profiler::Record(name, start, Profiler::Now());
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const char* name;
+        int64_t start;
+    };
+}
+
+#ifdef VULKAN_ENGINE_PROFILER_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ::VulkanEngine::ProfileScope PROFILE_CONCAT(profileScope, __LINE__){name}
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
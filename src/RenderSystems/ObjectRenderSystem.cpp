@@ -1,16 +1,20 @@
 #pragma once
 #include "ObjectRenderSystem.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <stdexcept>
 
 #include "Descriptors.hpp"
+#include "Profiler.hpp"
 
 namespace VulkanEngine
 {
     ObjectRenderSystem::ObjectRenderSystem(Device& device, VkRenderPass renderPass,
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts):
-        RenderSystem(device)
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts, bool meshletCulling):
+        RenderSystem(device),
+        meshletCulling(meshletCulling)
     {
         CreatePipelineLayout(descriptorSetLayouts);
         CreatePipeline(renderPass);
@@ -37,23 +41,94 @@ namespace VulkanEngine
 
     void ObjectRenderSystem::CreatePipeline(VkRenderPass renderPass)
     {
-        PipelineConfigInfo pipelineConfig{};
-        Pipeline::DefaultPipelineConfigInfo(
-            pipelineConfig);
-
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
-        pipeline = std::make_unique<Pipeline>(
-            device,
+        static constexpr std::array<const char*, static_cast<size_t>(Model::VertexFormat::Count)> vertexShaders{
             "../Shaders/vert_shader.vert.spv",
-            "../Shaders/frag_shader.frag.spv",
-            pipelineConfig);
+            "../Shaders/vert_shader_compact.vert.spv",
+            "../Shaders/vert_shader_compact_color.vert.spv"};
+
+        for (size_t i = 0; i < pipelines.size(); i++)
+        {
+            for (size_t j = 0; j < pipelines[i].size(); j++)
+            {
+                auto format = static_cast<Model::VertexFormat>(i);
+                auto streams = static_cast<Model::VertexStreams>(j);
+                PipelineConfigInfo pipelineConfig{};
+                Pipeline::DefaultPipelineConfigInfo(
+                    pipelineConfig);
+
+                pipelineConfig.bindingDescriptions = Model::GetBindingDescriptions(format, streams);
+                pipelineConfig.attributeDescriptions = Model::GetAttributeDescriptions(format, streams);
+                pipelineConfig.renderPass = renderPass;
+                pipelineConfig.pipelineLayout = pipelineLayout;
+                pipelines[i][j] = std::make_unique<Pipeline>(
+                    device,
+                    vertexShaders[i],
+                    "../Shaders/frag_shader.frag.spv",
+                    pipelineConfig);
+            }
+        }
     }
 
-    void ObjectRenderSystem::Render(FrameInfo frameInfo)
+    void ObjectRenderSystem::UpdateTextureDescriptor(GameObject& gameObject)
+    {
+        uint32_t generation = gameObject.texture->GetGeneration();
+        if (gameObject.textureGeneration == generation)
+        {
+            return;
+        }
+
+        // Set isn't used by any frame in flight, object wasn't drawn while its texture was evicted.
+        VkDescriptorImageInfo imageInfo = gameObject.texture->GetDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = gameObject.descriptorSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(device.GetDevice(), 1, &write, 0, nullptr);
+        gameObject.textureGeneration = generation;
+    }
+
+    uint32_t ObjectRenderSystem::SelectLod(const FrameInfo& frameInfo, GameObject& gameObject,
+                                           const glm::vec3& cameraPosition)
     {
-        pipeline->Bind(frameInfo.commandBuffer);
+        const Model& model = *gameObject.model;
+        uint32_t lodCount = model.GetLodCount();
+        const BoundingSphere& sphere = gameObject.GetWorldSphere();
+        if (lodCount <= 1 || model.GetBoundingSphere().radius <= 0.f)
+        {
+            return 0;
+        }
+
+        float distance = glm::length(sphere.center - cameraPosition) - sphere.radius;
+        if (distance <= 0.f)
+        {
+            gameObject.lodLevel = 0;
+            return 0;
+        }
+
+        // LOD errors are relative to extent of model bounds, which scales with object like its sphere
+        float extent = glm::length(model.GetBounds().GetExtent()) * sphere.radius / model.GetBoundingSphere().radius;
+        float projectedSize = extent * std::abs(frameInfo.camera.GetProjectionMatrix()[1][1]) * 0.5f *
+            static_cast<float>(frameInfo.extent.height) / distance;
+        uint32_t lod = std::min(gameObject.lodLevel, lodCount - 1);
+        while (lod > 0 && model.GetLodError(lod) * projectedSize > MAX_LOD_SCREEN_ERROR)
+        {
+            lod--;
+        }
+        while (lod + 1 < lodCount &&
+            model.GetLodError(lod + 1) * projectedSize <= MAX_LOD_SCREEN_ERROR * LOD_HYSTERESIS)
+        {
+            lod++;
+        }
+        gameObject.lodLevel = lod;
+        return lod;
+    }
 
+    void ObjectRenderSystem::Render(FrameInfo frameInfo)
+    {
+        PROFILE_SCOPE("ObjectRenderSystem::Render");
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -61,17 +136,69 @@ namespace VulkanEngine
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            1,
+            &frameInfo.globalUboOffset);
+
 
 
+        glm::mat4 viewProjection = frameInfo.camera.GetProjectionMatrix() * frameInfo.camera.GetViewMatrix();
+        Frustum frustum = Frustum::FromMatrix(viewProjection);
+        glm::vec3 cameraPosition{glm::inverse(frameInfo.camera.GetViewMatrix())[3]};
 
+        // Models share buffers of geometry pool pages, which are bound only when page changes
+        uint32_t boundPage = GeometryPool::INVALID_PAGE;
+        Pipeline* boundPipeline = nullptr;
         for (auto& kv : frameInfo.gameObjects)
         {
+            // Cached world bounds skip whole objects before residency and meshlets, so objects out of view
+            // age toward eviction and evicted ones aren't restored. Model keeps its bounds while evicted.
+            const BoundingSphere& sphere = kv.second.GetWorldSphere();
+            if (!sphere.IsEmpty() && !frustum.IsSphereVisible(sphere.center, sphere.radius))
+            {
+                continue;
+            }
+
+            // Evicted or still uploading resources are skipped until they are ready
+            if (!frameInfo.residency.Request(*kv.second.model))
+            {
+                continue;
+            }
+            if (kv.second.texture != nullptr)
+            {
+                if (!frameInfo.residency.Request(*kv.second.texture))
+                {
+                    continue;
+                }
+                UpdateTextureDescriptor(kv.second);
+            }
+
+            glm::mat4 transform = kv.second.transform.GetTransformationMatrix();
+            uint32_t lod = SelectLod(frameInfo, kv.second, cameraPosition);
+            if (meshletCulling)
+            {
+                // Meshlet bounds are in model space, so frustum and camera are moved there instead
+                drawCommands.clear();
+                kv.second.model->CullMeshlets(lod, Frustum::FromMatrix(viewProjection * transform),
+                                              glm::vec3{glm::inverse(transform) * glm::vec4{cameraPosition, 1.f}},
+                                              drawCommands);
+                if (drawCommands.empty() && kv.second.model->GetLodCount() > 0)
+                {
+                    continue;
+                }
+            }
+
             PushConstantData push{};
-            push.modelMatrix = kv.second.transform.GetTransformationMatrix();
+            // Compact positions are scaled back from model bounds by model matrix, normals aren't affected
+            push.modelMatrix = transform * kv.second.model->GetDequantizationMatrix();
             push.normalMatrix = kv.second.transform.GetNormalTransformationMatrix();
             push.hasTexture = kv.second.texture != nullptr;
+            Pipeline* modelPipeline = pipelines[static_cast<size_t>(kv.second.model->GetVertexFormat())]
+                                               [static_cast<size_t>(kv.second.model->GetVertexStreams())].get();
+            if (modelPipeline != boundPipeline)
+            {
+                modelPipeline->Bind(frameInfo.commandBuffer);
+                boundPipeline = modelPipeline;
+            }
             if(push.hasTexture)
             {
                 vkCmdBindDescriptorSets(
@@ -88,8 +215,21 @@ namespace VulkanEngine
                                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData),
                                &push);
 
-            kv.second.model->Bind(frameInfo.commandBuffer);
-            kv.second.model->Draw(frameInfo.commandBuffer);
+            if (kv.second.model->GetPage() != boundPage)
+            {
+                kv.second.model->Bind(frameInfo.commandBuffer);
+                boundPage = kv.second.model->GetPage();
+            }
+            if (!meshletCulling || kv.second.model->GetLodCount() == 0)
+            {
+                kv.second.model->Draw(frameInfo.commandBuffer, lod);
+                continue;
+            }
+            for (const auto& command : drawCommands)
+            {
+                vkCmdDrawIndexed(frameInfo.commandBuffer, command.indexCount, command.instanceCount,
+                                 command.firstIndex, command.vertexOffset, command.firstInstance);
+            }
         }
     }
 }
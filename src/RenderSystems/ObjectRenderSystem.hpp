@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <memory>
 
 #define GLM_FORCE_RADIANS
@@ -22,7 +23,15 @@ namespace VulkanEngine
     class ObjectRenderSystem : public RenderSystem
     {
     public:
-        ObjectRenderSystem(Device& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+        /// <summary>
+        /// Create render system.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="renderPass"> Render pass objects are drawn in</param>
+        /// <param name="descriptorSetLayouts"> Global and per object set layouts</param>
+        /// <param name="meshletCulling"> Cull meshlets of models on CPU, otherwise whole level is drawn</param>
+        ObjectRenderSystem(Device& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                           bool meshletCulling = true);
 
         /// <summary>
         /// Render all objects inside frameInfo.
@@ -30,10 +39,48 @@ namespace VulkanEngine
         /// <param name="frameInfo"> Information about current frame</param>
         void Render(FrameInfo frameInfo) override;
 
+        // Level is refined once its error projects to more pixels
+        static constexpr float MAX_LOD_SCREEN_ERROR = 1.f;
+        // Coarser level is taken only once its error is this fraction of MAX_LOD_SCREEN_ERROR,
+        // so objects near threshold don't switch level every frame
+        static constexpr float LOD_HYSTERESIS = 0.75f;
+
+        const char* GetName() const override
+        {
+            return "ObjectRenderSystem";
+        }
+
     private:
         void CreatePipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+        /// <summary>
+        /// Create pipeline for each vertex format and streams, they differ in vertex input and vertex shader only.
+        /// </summary>
         void CreatePipeline(VkRenderPass renderPass);
 
+        /// <summary>
+        /// Write texture into descriptor set of object, if texture got new image since last write.
+        /// </summary>
+        /// <param name="gameObject"> Object with resident texture</param>
+        void UpdateTextureDescriptor(GameObject& gameObject);
+
+        /// <summary>
+        /// Select level of detail of object from projected size of its world bounding sphere, level is
+        /// remembered in object for hysteresis.
+        /// </summary>
+        /// <param name="frameInfo"> Information about current frame</param>
+        /// <param name="gameObject"> Object with resident model</param>
+        /// <param name="cameraPosition"> Camera position in world space</param>
+        /// <returns> Level of detail to draw</returns>
+        uint32_t SelectLod(const FrameInfo& frameInfo, GameObject& gameObject, const glm::vec3& cameraPosition);
+
+        // Indexed by vertex format and vertex streams of model
+        std::array<std::array<std::unique_ptr<Pipeline>, static_cast<size_t>(Model::VertexStreams::Count)>,
+                   static_cast<size_t>(Model::VertexFormat::Count)> pipelines;
+
+        bool meshletCulling;
+        // Draws of visible meshlets of current object, kept to reuse allocation
+        std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+
         struct PushConstantData
         {
             glm::mat4 modelMatrix{1.f};
@@ -7,8 +7,9 @@
 
 namespace VulkanEngine
 {
-    OffscreenRenderer::OffscreenRenderer(Device& device, int width, int height, VkFormat depthFormat):
-    device(device),width(width),height(height), depthFormat(depthFormat)
+    OffscreenRenderer::OffscreenRenderer(Device& device, int width, int height, VkFormat colorFormat,
+                                         VkFormat depthFormat):
+        device(device), width(width), height(height), colorFormat(colorFormat), depthFormat(depthFormat)
     {
         CreateRenderPass();
         CreateFramebuffer();
@@ -19,12 +20,12 @@ namespace VulkanEngine
         // Color attachment
         vkDestroyImageView(device.GetDevice(), colorAttachment.view, nullptr);
         vkDestroyImage(device.GetDevice(), colorAttachment.image, nullptr);
-        vkFreeMemory(device.GetDevice(), colorAttachment.mem, nullptr);
+        device.FreeMemory(colorAttachment.mem);
 
         // Depth attachment
         vkDestroyImageView(device.GetDevice(), depthAttachment.view, nullptr);
         vkDestroyImage(device.GetDevice(), depthAttachment.image, nullptr);
-        vkFreeMemory(device.GetDevice(), depthAttachment.mem, nullptr);
+        device.FreeMemory(depthAttachment.mem);
 
         vkDestroyFramebuffer(device.GetDevice(), framebuffer, nullptr);
 
@@ -33,21 +34,23 @@ namespace VulkanEngine
 
     void OffscreenRenderer::CreateFramebuffer()
     {
-        VkImageCreateInfo imageInfo;
-        Image::DefaultImageCreateInfo(imageInfo, width, height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-        VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1 };
-        device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorAttachment.image, colorAttachment.mem);
-        device.TransitionImageLayout(colorAttachment.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, subresourceRange);
-        device.CreateImageView(colorAttachment.image, VK_FORMAT_R32_SFLOAT, colorAttachment.view, subresourceRange);
-
-        subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        // Attachments are cleared on load, so render pass takes care of their layouts.
+        VkImageCreateInfo imageInfo = {};
+        Image::DefaultImageCreateInfo(imageInfo, width, height, colorFormat,
+                                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorAttachment.image,
+                                   colorAttachment.mem);
+        device.CreateImageView(colorAttachment.image, colorFormat, colorAttachment.view,
+                               Device::defaultSubresourceRange);
+
         imageInfo.format = depthFormat;
         imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-        device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthAttachment.image, depthAttachment.mem);
-        device.TransitionImageLayout(colorAttachment.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, subresourceRange);
-        device.CreateImageView(depthAttachment.image, depthFormat, depthAttachment.view, subresourceRange);
+        device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthAttachment.image,
+                                   depthAttachment.mem);
+        device.CreateImageView(depthAttachment.image, depthFormat, depthAttachment.view,
+                               {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1});
 
-        std::array<VkImageView, 2> attachments = { colorAttachment.view, depthAttachment.view };
+        std::array<VkImageView, 2> attachments = {colorAttachment.view, depthAttachment.view};
 
         VkFramebufferCreateInfo framebufferInfo = {};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -72,14 +75,14 @@ namespace VulkanEngine
     {
         VkAttachmentDescription colorAttachment = {};
 
-        colorAttachment.format = VK_FORMAT_R32_SFLOAT;
+        colorAttachment.format = colorFormat;
         colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
         // Depth attachment
         VkAttachmentDescription depthAttachment = {};
@@ -89,10 +92,10 @@ namespace VulkanEngine
         depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-        std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+        std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
 
         VkAttachmentReference colorReference = {};
         colorReference.attachment = 0;
@@ -108,13 +111,37 @@ namespace VulkanEngine
         subpass.pColorAttachments = &colorReference;
         subpass.pDepthStencilAttachment = &depthReference;
 
+        // Previous frame could still use the same attachments, so wait for its writes.
+        std::array<VkSubpassDependency, 2> dependencies = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask =
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[0].dstStageMask =
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        // Make color output visible to transfers, which may read it back.
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
         VkRenderPassCreateInfo renderPassCreateInfo = {};
-        renderPassCreateInfo.attachmentCount = sizeof(attachments);
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
         renderPassCreateInfo.pAttachments = attachments.data();
         renderPassCreateInfo.subpassCount = 1;
         renderPassCreateInfo.pSubpasses = &subpass;
+        renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassCreateInfo.pDependencies = dependencies.data();
 
-        if(vkCreateRenderPass(device.GetDevice(), &renderPassCreateInfo, nullptr, &renderPass))
+        if (vkCreateRenderPass(device.GetDevice(), &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create render pass!");
         }
@@ -1,21 +1,245 @@
 #pragma once
 #include "OffscreenShadowRenderSystem.hpp"
+
+#include <stdexcept>
+
+#include "Profiler.hpp"
+
 namespace VulkanEngine
 {
-    OffscreenShadowRenderSystem::OffscreenShadowRenderSystem(Device& device, VkRenderPass renderPass,
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
-            :RenderSystem(device)
+    OffscreenShadowRenderSystem::OffscreenShadowRenderSystem(Device& device)
+            :RenderSystem(device),
+            depthFormat(device.FindDepthFormat())
     {
+        CreateRenderPass();
+        CreateShadowMaps();
+        CreatePipelineLayout();
+        CreatePipeline(renderPass);
+        SetLight({-1.f, -1.f, -1.f}, {0.f, 0.f, 0.f});
     }
-    void OffscreenShadowRenderSystem::Render(FrameInfo frameInfo)
+
+    OffscreenShadowRenderSystem::~OffscreenShadowRenderSystem()
+    {
+        for (size_t i = 0; i < shadowMaps.size(); i++)
+        {
+            vkDestroyFramebuffer(device.GetDevice(), framebuffers[i], nullptr);
+            vkDestroyImageView(device.GetDevice(), shadowMaps[i].view, nullptr);
+            vkDestroyImage(device.GetDevice(), shadowMaps[i].image, nullptr);
+            device.FreeMemory(shadowMaps[i].mem);
+        }
+        vkDestroyRenderPass(device.GetDevice(), renderPass, nullptr);
+    }
+
+    void OffscreenShadowRenderSystem::SetLight(glm::vec3 position, glm::vec3 target)
+    {
+        lightCamera.SetViewTarget(position, target);
+        lightCamera.SetPerspectiveProjection(glm::radians(90.f), 1.f, 0.1f, 10.f);
+    }
+
+    void OffscreenShadowRenderSystem::CreateRenderPass()
     {
+        VkAttachmentDescription depthAttachment = {};
+        depthAttachment.format = depthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+        VkAttachmentReference depthReference = {};
+        depthReference.attachment = 0;
+        depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 0;
+        subpass.pDepthStencilAttachment = &depthReference;
+
+        // Shadow map of this slot could still be read by fragment shaders of previous frame.
+        std::array<VkSubpassDependency, 2> dependencies = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        // Make depth visible to fragment shaders sampling shadow map.
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        VkRenderPassCreateInfo renderPassCreateInfo = {};
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.attachmentCount = 1;
+        renderPassCreateInfo.pAttachments = &depthAttachment;
+        renderPassCreateInfo.subpassCount = 1;
+        renderPassCreateInfo.pSubpasses = &subpass;
+        renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassCreateInfo.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(device.GetDevice(), &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create render pass!");
+        }
     }
 
-    void OffscreenShadowRenderSystem::CreatePipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
+    void OffscreenShadowRenderSystem::CreateShadowMaps()
     {
+        VkImageCreateInfo imageInfo = {};
+        Image::DefaultImageCreateInfo(imageInfo, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, depthFormat,
+                                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+        for (size_t i = 0; i < shadowMaps.size(); i++)
+        {
+            device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowMaps[i].image,
+                                       shadowMaps[i].mem);
+            device.CreateImageView(shadowMaps[i].image, depthFormat, shadowMaps[i].view,
+                                   {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1});
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &shadowMaps[i].view;
+            framebufferInfo.width = SHADOW_MAP_SIZE;
+            framebufferInfo.height = SHADOW_MAP_SIZE;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(device.GetDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create framebuffer!");
+            }
+        }
+    }
+
+    void OffscreenShadowRenderSystem::CreatePipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.size = sizeof(PushConstantData);
+        pushConstantRange.offset = 0;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 0;
+        pipelineLayoutInfo.pSetLayouts = nullptr;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device.GetDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to pipeline layout!");
+        }
     }
 
     void OffscreenShadowRenderSystem::CreatePipeline(VkRenderPass renderPass)
     {
+        for (size_t i = 0; i < pipelines.size(); i++)
+        {
+            for (size_t j = 0; j < pipelines[i].size(); j++)
+            {
+                auto format = static_cast<Model::VertexFormat>(i);
+                auto streams = static_cast<Model::VertexStreams>(j);
+                PipelineConfigInfo pipelineConfig{};
+                Pipeline::DefaultPipelineConfigInfo(
+                    pipelineConfig);
+
+                // Only position is read, from tightly packed stream if model has one
+                pipelineConfig.bindingDescriptions = Model::GetPositionBindingDescriptions(format, streams);
+                pipelineConfig.attributeDescriptions = Model::GetPositionAttributeDescriptions(format);
+
+                // No color attachments, bias against shadow acne
+                pipelineConfig.colorBlendInfo.attachmentCount = 0;
+                pipelineConfig.colorBlendInfo.pAttachments = nullptr;
+                pipelineConfig.rasterizationInfo.depthBiasEnable = VK_TRUE;
+                pipelineConfig.rasterizationInfo.depthBiasConstantFactor = 1.25f;
+                pipelineConfig.rasterizationInfo.depthBiasSlopeFactor = 1.75f;
+
+                pipelineConfig.renderPass = renderPass;
+                pipelineConfig.pipelineLayout = pipelineLayout;
+                pipelines[i][j] = std::make_unique<Pipeline>(
+                    device,
+                    "../Shaders/depth_only.vert.spv",
+                    "../Shaders/depth_only.frag.spv",
+                    pipelineConfig);
+            }
+        }
+    }
+
+    void OffscreenShadowRenderSystem::Render(FrameInfo frameInfo)
+    {
+        PROFILE_SCOPE("OffscreenShadowRenderSystem::Render");
+
+        VkClearValue clearValue{};
+        clearValue.depthStencil = {1.0f, 0};
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffers[frameInfo.frameIndex];
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearValue;
+        vkCmdBeginRenderPass(frameInfo.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{0.f, 0.f, static_cast<float>(SHADOW_MAP_SIZE), static_cast<float>(SHADOW_MAP_SIZE),
+                            0.f, 1.f};
+        VkRect2D scissor{{0, 0}, {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE}};
+        vkCmdSetViewport(frameInfo.commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(frameInfo.commandBuffer, 0, 1, &scissor);
+
+        glm::mat4 lightViewProjection = lightCamera.GetProjectionMatrix() * lightCamera.GetViewMatrix();
+        Frustum lightFrustum = Frustum::FromMatrix(lightViewProjection);
+
+        uint32_t boundPage = GeometryPool::INVALID_PAGE;
+        Pipeline* boundPipeline = nullptr;
+        for (auto& kv : frameInfo.gameObjects)
+        {
+            if (kv.second.model == nullptr)
+            {
+                continue;
+            }
+            // Objects outside of light frustum cast nothing into shadow map, they aren't requested so they can
+            // be evicted
+            const BoundingSphere& sphere = kv.second.GetWorldSphere();
+            if (!sphere.IsEmpty() && !lightFrustum.IsSphereVisible(sphere.center, sphere.radius))
+            {
+                continue;
+            }
+            if (!frameInfo.residency.Request(*kv.second.model))
+            {
+                continue;
+            }
+            Model& model = *kv.second.model;
+
+            Pipeline* modelPipeline = pipelines[static_cast<size_t>(model.GetVertexFormat())]
+                                               [static_cast<size_t>(model.GetVertexStreams())].get();
+            if (modelPipeline != boundPipeline)
+            {
+                modelPipeline->Bind(frameInfo.commandBuffer);
+                boundPipeline = modelPipeline;
+            }
+            if (model.GetPage() != boundPage)
+            {
+                model.BindPositions(frameInfo.commandBuffer);
+                boundPage = model.GetPage();
+            }
+
+            PushConstantData push{};
+            push.modelViewProjection = lightViewProjection * kv.second.transform.GetTransformationMatrix() *
+                model.GetDequantizationMatrix();
+            vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                               sizeof(PushConstantData), &push);
+            // Level selected for camera last frame, shadow doesn't need more detail than object itself
+            model.Draw(frameInfo.commandBuffer, kv.second.lodLevel);
+        }
+
+        vkCmdEndRenderPass(frameInfo.commandBuffer);
     }
 }
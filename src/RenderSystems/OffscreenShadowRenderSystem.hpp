@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <memory>
 
 #define GLM_FORCE_RADIANS
@@ -12,30 +13,72 @@
 #include "Camera.hpp"
 #include "Descriptors.hpp"
 #include "FrameInfo.hpp"
+#include "OffscreenRenderer.hpp"
 #include "RenderSystem.hpp"
+#include "SwapChain.hpp"
 
 namespace VulkanEngine
 {
     /// <summary>
-    /// Class to render shadows to offscreen renderer
+    /// Class to render shadows to offscreen renderer. Objects are rendered depth only from light into shadow map
+    /// of current frame, fetching positions only. It records its own render pass, so it must be rendered before
+    /// swap chain render pass begins.
     /// </summary>
     class OffscreenShadowRenderSystem : public RenderSystem
     {
     public:
-        OffscreenShadowRenderSystem(Device& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+        static constexpr uint32_t SHADOW_MAP_SIZE = 1024;
+
+        OffscreenShadowRenderSystem(Device& device);
+        ~OffscreenShadowRenderSystem();
+
         /// <summary>
         /// Render all objects inside frameInfo.
         /// </summary>
         /// <param name="frameInfo"> Information about current frame</param>
         void Render(FrameInfo frameInfo) override;
 
+        const char* GetName() const override
+        {
+            return "OffscreenShadowRenderSystem";
+        }
+
+        /// <summary>
+        /// Place perspective light camera.
+        /// </summary>
+        /// <param name="position"> Light position</param>
+        /// <param name="target"> Point light is looking at</param>
+        void SetLight(glm::vec3 position, glm::vec3 target);
+
+        /// <summary>
+        /// Shadow map written by frame, it is in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL after render pass.
+        /// </summary>
+        /// <param name="frameIndex"> Index of frame in flight</param>
+        const FrameBufferAttachment& GetShadowMap(int frameIndex) const
+        {
+            return shadowMaps[frameIndex];
+        }
+
     private:
-        void CreatePipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+        void CreatePipelineLayout();
         void CreatePipeline(VkRenderPass renderPass);
+        void CreateRenderPass();
+        void CreateShadowMaps();
+
+        // Indexed by vertex format and vertex streams of model
+        std::array<std::array<std::unique_ptr<Pipeline>, static_cast<size_t>(Model::VertexStreams::Count)>,
+                   static_cast<size_t>(Model::VertexFormat::Count)> pipelines;
+
+        VkFormat depthFormat;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        // Each frame in flight has own shadow map, so it can be read while next frame renders
+        std::array<FrameBufferAttachment, SwapChain::MAX_FRAMES_IN_FLIGHT> shadowMaps{};
+        std::array<VkFramebuffer, SwapChain::MAX_FRAMES_IN_FLIGHT> framebuffers{};
+        Camera lightCamera{};
 
         struct PushConstantData
         {
-            glm::mat4 viewMatrix{ 1.f };
+            glm::mat4 modelViewProjection{ 1.f };
         };
     };
 }
@@ -4,6 +4,8 @@
 #include <array>
 #include <stdexcept>
 
+#include "Profiler.hpp"
+
 namespace VulkanEngine
 {
     PointLightSystem::PointLightSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout):
@@ -52,6 +54,7 @@ namespace VulkanEngine
 
     void PointLightSystem::Render(FrameInfo frameInfo)
     {
+        PROFILE_SCOPE("PointLightSystem::Render");
         pipeline->Bind(frameInfo.commandBuffer);
 
         vkCmdBindDescriptorSets(
@@ -61,8 +64,8 @@ namespace VulkanEngine
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            1,
+            &frameInfo.globalUboOffset);
 
         vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
     }
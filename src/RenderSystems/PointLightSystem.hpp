@@ -29,6 +29,11 @@ namespace VulkanEngine
         /// <param name="frameInfo"> Current frame info</param>
         void Render(FrameInfo frameInfo) override;
 
+        const char* GetName() const override
+        {
+            return "PointLightSystem";
+        }
+
     private:
         void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
         void CreatePipeline(VkRenderPass renderPass);
@@ -32,6 +32,12 @@ namespace VulkanEngine
         /// </summary>
         /// <param name="frameInfo"> Information about current frame</param>
         virtual void Render(FrameInfo frameInfo) = 0;
+
+        /// <summary>
+        /// Name of render system used in profiling results.
+        /// </summary>
+        /// <returns> Static name string</returns>
+        virtual const char* GetName() const = 0;
     protected:
         Device& device;
         std::unique_ptr<Pipeline> pipeline;
@@ -1,22 +1,77 @@
 #pragma once
 #include "Renderer.hpp"
+#include "Profiler.hpp"
+#include "UploadContext.hpp"
 
 #include <array>
+#include <limits>
 #include <stdexcept>
 
 namespace VulkanEngine
 {
     Renderer::Renderer(Window& window, Device& device):
-        window(window),
+        window(&window),
         device(device)
     {
         RecreateSwapChain();
         CreateCommandBuffers();
+        gpuProfiler = std::make_unique<GpuProfiler>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+        device.GetDeletionQueue().SetFramesInFlight(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    }
+
+    Renderer::Renderer(Device& device, VkExtent2D extent):
+        device(device),
+        offscreenExtent(extent)
+    {
+        CreateOffscreenTargets();
+        CreateCommandBuffers();
+        gpuProfiler = std::make_unique<GpuProfiler>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+        device.GetDeletionQueue().SetFramesInFlight(SwapChain::MAX_FRAMES_IN_FLIGHT);
     }
 
     Renderer::~Renderer()
     {
+        // Nothing is rendered anymore, so postponed resources can go and later ones are destroyed immediately.
+        vkDeviceWaitIdle(device.GetDevice());
+        device.GetDeletionQueue().SetFramesInFlight(0);
+        device.GetDeletionQueue().Flush();
         FreeCommandBuffers();
+        DestroyOffscreenTargets();
+    }
+
+    void Renderer::CreateOffscreenTargets()
+    {
+        VkFormat depthFormat = device.FindDepthFormat();
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        offscreenFences.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            offscreenTargets.push_back(std::make_unique<OffscreenRenderer>(
+                device,
+                static_cast<int>(offscreenExtent.width),
+                static_cast<int>(offscreenExtent.height),
+                OFFSCREEN_COLOR_FORMAT,
+                depthFormat));
+
+            if (vkCreateFence(device.GetDevice(), &fenceInfo, nullptr, &offscreenFences[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create synchronization objects for a frame!");
+            }
+        }
+    }
+
+    void Renderer::DestroyOffscreenTargets()
+    {
+        for (auto fence : offscreenFences)
+        {
+            vkDestroyFence(device.GetDevice(), fence, nullptr);
+        }
+        offscreenFences.clear();
+        offscreenTargets.clear();
     }
 
     void Renderer::CreateCommandBuffers()
@@ -47,14 +102,16 @@ namespace VulkanEngine
 
     void Renderer::RecreateSwapChain()
     {
-        auto extent = window.getExtent();
+        PROFILE_SCOPE("Renderer::RecreateSwapChain");
+        auto extent = window->getExtent();
         while (extent.width == 0 || extent.height == 0)
         {
-            extent = window.getExtent();
+            extent = window->getExtent();
             glfwWaitEvents();
         }
 
         vkDeviceWaitIdle(device.GetDevice());
+        device.GetDeletionQueue().Flush();
         if (swapChain != nullptr)
         {
             std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
@@ -73,20 +130,38 @@ namespace VulkanEngine
 
     VkCommandBuffer Renderer::BeginFrame()
     {
+        PROFILE_SCOPE("Renderer::BeginFrame");
         assert(!isFrameStarted);
 
-        auto result = swapChain->AcquireNextImage(&currentImageIndex);
-
-        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        if (IsHeadless())
         {
-            RecreateSwapChain();
-            return nullptr;
+            // Wait until previous frame using this target is finished.
+            vkWaitForFences(
+                device.GetDevice(),
+                1,
+                &offscreenFences[currentFrameIndex],
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max());
+            currentImageIndex = static_cast<uint32_t>(currentFrameIndex);
         }
-        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        else
         {
-            throw std::runtime_error("failed to acquire next image");
+            auto result = swapChain->AcquireNextImage(&currentImageIndex);
+
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                RecreateSwapChain();
+                return nullptr;
+            }
+            if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+            {
+                throw std::runtime_error("failed to acquire next image");
+            }
         }
 
+        // Fence of this slot was waited for, so frame which used it last retired.
+        device.GetDeletionQueue().BeginFrame();
+
         isFrameStarted = true;
         auto commandBuffer = GetCurrentCommandBuffer();
 
@@ -99,11 +174,14 @@ namespace VulkanEngine
             throw std::runtime_error("failed to start recording command buffer");
         }
 
+        gpuProfiler->BeginFrame(commandBuffer, currentFrameIndex, frameNumber);
+
         return commandBuffer;
     }
 
     void Renderer::EndFrame()
     {
+        PROFILE_SCOPE("Renderer::EndFrame");
         // End command buffer
         assert(isFrameStarted);
         auto commandBuffer = GetCurrentCommandBuffer();
@@ -112,34 +190,71 @@ namespace VulkanEngine
             throw std::runtime_error("failed to stop recording command buffer");
         }
 
-        // Submit command buffer.
-        auto result = swapChain->SubmitCommandBuffers(&commandBuffer, &currentImageIndex);
+        // Uploads recorded since last frame go to queue before frame, which then sees their data.
+        device.GetUploadContext().Submit();
+        device.GetUploadContext().Collect();
 
-        // Check if window was resized
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.WasWindowResized())
+        if (IsHeadless())
+        {
+            // Nothing to present, just submit and signal fence of this frame.
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+
+            vkResetFences(device.GetDevice(), 1, &offscreenFences[currentFrameIndex]);
+            if (vkQueueSubmit(device.GraphicsQueue(), 1, &submitInfo, offscreenFences[currentFrameIndex]) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+        }
+        else
         {
-            // Adjust swapChain to new size
-            window.ResetWindowResizedFlag();
-            RecreateSwapChain();
+            // Submit command buffer.
+            auto result = swapChain->SubmitCommandBuffers(&commandBuffer, &currentImageIndex);
+
+            // Check if window was resized
+            if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window->WasWindowResized())
+            {
+                // Adjust swapChain to new size
+                window->ResetWindowResizedFlag();
+                RecreateSwapChain();
+            }
         }
 
         isFrameStarted = false;
+        device.GetDeletionQueue().EndFrame();
+        frameNumber++;
         currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
     void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
     {
+        PROFILE_SCOPE("Renderer::BeginSwapChainRenderPass");
         assert(isFrameStarted);
         assert(commandBuffer == GetCurrentCommandBuffer());
 
         // Create render pass
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = swapChain->GetRenderPass();
-        renderPassInfo.framebuffer = swapChain->GetFrameBuffer(currentImageIndex);
+        VkExtent2D extent;
+        if (IsHeadless())
+        {
+            auto& target = offscreenTargets[currentImageIndex];
+            renderPassInfo.renderPass = target->GetRenderPass();
+            renderPassInfo.framebuffer = target->GetFramebuffer();
+            extent = target->GetExtent();
+        }
+        else
+        {
+            renderPassInfo.renderPass = swapChain->GetRenderPass();
+            renderPassInfo.framebuffer = swapChain->GetFrameBuffer(currentImageIndex);
+            extent = swapChain->GetSwapChainExtent();
+        }
 
         renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChain->GetSwapChainExtent();
+        renderPassInfo.renderArea.extent = extent;
 
         // Create clear information
         std::array<VkClearValue, 2> clearValues{};
@@ -148,26 +263,29 @@ namespace VulkanEngine
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
+        renderPassZone = gpuProfiler->BeginZone(commandBuffer, "RenderPass");
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         // Set viewport and scissor
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = static_cast<float>(swapChain->GetSwapChainExtent().width);
-        viewport.height = static_cast<float>(swapChain->GetSwapChainExtent().height);
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        VkRect2D scissor{{0, 0}, swapChain->GetSwapChainExtent()};
+        VkRect2D scissor{{0, 0}, extent};
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
 
     void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer)
     {
+        PROFILE_SCOPE("Renderer::EndSwapChainRenderPass");
         assert(isFrameStarted);
         assert(commandBuffer == GetCurrentCommandBuffer());
 
         vkCmdEndRenderPass(commandBuffer);
+        gpuProfiler->EndZone(commandBuffer, renderPassZone);
     }
 }
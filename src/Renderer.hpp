@@ -9,6 +9,8 @@
 #include "Model.hpp"
 #include "Window.hpp"
 #include "SwapChain.hpp"
+#include "OffscreenRenderer.hpp"
+#include "GpuProfiler.hpp"
 
 namespace VulkanEngine
 {
@@ -18,21 +20,45 @@ namespace VulkanEngine
     class Renderer
     {
     public:
+        static constexpr VkFormat OFFSCREEN_COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
         /// <summary>
         /// Create swap chain and command buffer pool for new renderer
         /// </summary>
         /// <param name="window"> current window</param>
         /// <param name="device"> current device</param>
         Renderer(Window& window, Device& device);
+
+        /// <summary>
+        /// Create headless renderer. Frames are rendered into offscreen attachments
+        /// instead of swap chain images and nothing is presented.
+        /// </summary>
+        /// <param name="device"> current device</param>
+        /// <param name="extent"> size of offscreen attachments</param>
+        Renderer(Device& device, VkExtent2D extent);
         ~Renderer();
         Renderer(const Renderer&) = delete;
         Renderer& operator=(const Renderer&) = delete;
 
         float GetAspectRatio() const
         {
+            if (IsHeadless())
+            {
+                return static_cast<float>(offscreenExtent.width) / static_cast<float>(offscreenExtent.height);
+            }
             return swapChain->ExtentAspectRatio();
         }
 
+        VkExtent2D GetExtent() const
+        {
+            return IsHeadless() ? offscreenExtent : swapChain->GetSwapChainExtent();
+        }
+
+        bool IsHeadless() const
+        {
+            return window == nullptr;
+        }
+
         bool isFrameInProgress() const
         {
             return isFrameStarted;
@@ -47,6 +73,11 @@ namespace VulkanEngine
 
         VkRenderPass getSwapChainRenderPass() const
         {
+            // All offscreen targets have compatible render passes, so any of them can be used for pipelines.
+            if (IsHeadless())
+            {
+                return offscreenTargets[0]->GetRenderPass();
+            }
             return swapChain->GetRenderPass();
         }
 
@@ -56,6 +87,16 @@ namespace VulkanEngine
             return currentFrameIndex;
         }
 
+        uint32_t GetFrameNumber() const
+        {
+            return frameNumber;
+        }
+
+        GpuProfiler& GetGpuProfiler()
+        {
+            return *gpuProfiler;
+        }
+
         /// <summary>
         /// Start new frame.
         /// </summary>
@@ -95,13 +136,34 @@ namespace VulkanEngine
         /// </summary>
         void RecreateSwapChain();
 
-        Window& window;
+        /// <summary>
+        /// Create offscreen targets and fences used instead of swap chain in headless mode.
+        /// </summary>
+        void CreateOffscreenTargets();
+
+        /// <summary>
+        /// Destroy offscreen targets fences.
+        /// </summary>
+        void DestroyOffscreenTargets();
+
+        Window* window = nullptr;
         Device& device;
         std::unique_ptr<SwapChain> swapChain;
         std::vector<VkCommandBuffer> commandBuffers;
 
+        // Headless mode only, one target per frame in flight
+        VkExtent2D offscreenExtent{};
+        std::vector<std::unique_ptr<OffscreenRenderer>> offscreenTargets;
+        std::vector<VkFence> offscreenFences;
+
+        std::unique_ptr<GpuProfiler> gpuProfiler;
+        uint32_t renderPassZone = GpuProfiler::INVALID_ZONE;
+
         uint32_t currentImageIndex = 0;
         int currentFrameIndex = 0;
         bool isFrameStarted = false;
+
+        // Number of frames started since renderer creation
+        uint32_t frameNumber = 0;
     };
 }
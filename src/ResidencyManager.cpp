@@ -0,0 +1,164 @@
+#include "ResidencyManager.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    ResidencyManager::ResidencyManager(Device& device, uint32_t framesInFlight):
+        device(device),
+        framesInFlight(framesInFlight)
+    {
+    }
+
+    void ResidencyManager::Register(const std::shared_ptr<EvictableResource>& resource)
+    {
+        resource->lastUsedFrame = currentFrame;
+        resources.push_back(resource);
+    }
+
+    VkDeviceSize ResidencyManager::GetBytesOverBudget(double budgetRatio) const
+    {
+        VkDeviceSize over = 0;
+        for (const auto& heap : device.GetMemoryBudget())
+        {
+            if (!(heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+            {
+                continue;
+            }
+            auto limit = static_cast<VkDeviceSize>(heap.budget * budgetRatio);
+            if (heap.usage > limit)
+            {
+                over = std::max(over, heap.usage - limit);
+            }
+        }
+        return over;
+    }
+
+    void ResidencyManager::BeginFrame()
+    {
+        PROFILE_SCOPE("ResidencyManager::BeginFrame");
+        currentFrame++;
+
+        // Drop resources which were destroyed
+        resources.erase(std::remove_if(resources.begin(), resources.end(),
+                                       [](const std::weak_ptr<EvictableResource>& resource)
+                                       {
+                                           return resource.expired();
+                                       }), resources.end());
+
+        device.UpdateMemoryBudget();
+        if (currentFrame >= nextEvictionFrame && GetBytesOverBudget(EVICTION_THRESHOLD) > 0)
+        {
+            EvictLeastRecentlyUsed(GetBytesOverBudget(EVICTION_TARGET));
+        }
+    }
+
+    VkDeviceSize ResidencyManager::EvictLeastRecentlyUsed(VkDeviceSize bytes)
+    {
+        UploadContext& uploadContext = device.GetUploadContext();
+
+        // Resources sharing memory, e.g. models of one geometry pool page, are evicted together, since memory
+        // is released only when none of them stays resident. Group can be evicted if all its resources can
+        // and it holds all users of memory, memory kept by resources not registered here is never released.
+        struct Group
+        {
+            uint64_t lastUsedFrame = 0;
+            bool evictable = true;
+            uint32_t userCount = 1;
+            std::vector<std::shared_ptr<EvictableResource>> resources;
+        };
+        std::vector<Group> groups;
+        std::unordered_map<uint64_t, size_t> sharedGroups;
+        for (auto& weak : resources)
+        {
+            auto resource = weak.lock();
+            if (resource == nullptr || !resource->IsResident())
+            {
+                continue;
+            }
+            // Frames in flight may use resource, its upload may be still running.
+            bool evictable = resource->CanEvict() && resource->lastUsedFrame + framesInFlight < currentFrame &&
+                uploadContext.IsComplete(resource->GetUploadToken());
+            uint64_t key = resource->GetSharedMemoryKey();
+            if (key == 0 && !evictable)
+            {
+                continue;
+            }
+
+            size_t index = groups.size();
+            if (key != 0)
+            {
+                index = sharedGroups.emplace(key, groups.size()).first->second;
+            }
+            if (index == groups.size())
+            {
+                groups.emplace_back();
+            }
+            Group& group = groups[index];
+            group.userCount = resource->GetSharedMemoryUserCount();
+            group.lastUsedFrame = std::max(group.lastUsedFrame, resource->lastUsedFrame);
+            group.evictable = group.evictable && evictable;
+            group.resources.push_back(std::move(resource));
+        }
+        groups.erase(std::remove_if(groups.begin(), groups.end(), [](const Group& group)
+        {
+            return !group.evictable || group.resources.size() < group.userCount;
+        }), groups.end());
+        std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b)
+        {
+            return a.lastUsedFrame < b.lastUsedFrame;
+        });
+
+        // Only memory which is really released counts
+        VkDeviceSize evicted = 0;
+        for (auto& group : groups)
+        {
+            if (evicted >= bytes)
+            {
+                break;
+            }
+            for (auto& resource : group.resources)
+            {
+                evicted += resource->Evict();
+                statistics.evictions++;
+            }
+        }
+        statistics.evictedBytes += evicted;
+
+        if (evicted > 0)
+        {
+            nextEvictionFrame = currentFrame + framesInFlight + 1;
+        }
+        return evicted;
+    }
+
+    bool ResidencyManager::Request(EvictableResource& resource)
+    {
+        resource.lastUsedFrame = currentFrame;
+        if (!resource.IsResident())
+        {
+            if (currentFrame < resource.restoreRetryFrame)
+            {
+                return false;
+            }
+
+            try
+            {
+                resource.Restore();
+                statistics.restores++;
+            }
+            catch (const OutOfMemoryError&)
+            {
+                // Evicted memory is freed after frames in flight finish, so next try waits for them.
+                statistics.failedRestores++;
+                VkDeviceSize evicted = EvictLeastRecentlyUsed(resource.GetMemorySize());
+                resource.restoreRetryFrame = currentFrame + (evicted > 0 ? framesInFlight + 1 : RESTORE_RETRY_FRAMES);
+                return false;
+            }
+        }
+        return device.GetUploadContext().IsComplete(resource.GetUploadToken());
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Device.hpp"
+#include "EvictableResource.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Keeps device memory usage under budget by evicting least recently drawn resources and restores them
+    /// when they are drawn again. Memory exhausted while restoring is handled by evicting more and trying
+    /// again later, so scenes bigger than device memory degrade to missing objects instead of failing.
+    /// </summary>
+    class ResidencyManager
+    {
+    public:
+        // Eviction starts when usage of device local heap reaches this part of its budget
+        static constexpr double EVICTION_THRESHOLD = 0.9;
+        // Eviction releases memory down to this part of budget, so it doesn't run every frame
+        static constexpr double EVICTION_TARGET = 0.8;
+        // Frames to wait before restore which failed is tried again, if nothing could be evicted for it
+        static constexpr uint64_t RESTORE_RETRY_FRAMES = 60;
+
+        struct Statistics
+        {
+            uint64_t evictions = 0;
+            VkDeviceSize evictedBytes = 0;
+            uint64_t restores = 0;
+            uint64_t failedRestores = 0;
+        };
+
+        /// <summary>
+        /// Create manager without resources.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="framesInFlight"> Resource is evicted only if no frame in flight used it</param>
+        ResidencyManager(Device& device, uint32_t framesInFlight);
+
+        ResidencyManager(const ResidencyManager&) = delete;
+        ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+        /// <summary>
+        /// Let manager evict resource. Manager doesn't keep resource alive.
+        /// </summary>
+        /// <param name="resource"> Resource which can be evicted</param>
+        void Register(const std::shared_ptr<EvictableResource>& resource);
+
+        /// <summary>
+        /// Update memory budget and evict resources if usage is near it. Called before recording frame.
+        /// </summary>
+        void BeginFrame();
+
+        /// <summary>
+        /// Mark resource as used by current frame, restore it if it is evicted.
+        /// </summary>
+        /// <param name="resource"> Resource to be drawn</param>
+        /// <returns> true if resource can be used in current frame</returns>
+        bool Request(EvictableResource& resource);
+
+        const Statistics& GetStatistics() const
+        {
+            return statistics;
+        }
+
+    private:
+        /// <summary>
+        /// Bytes over given part of budget, highest of all device local heaps.
+        /// </summary>
+        VkDeviceSize GetBytesOverBudget(double budgetRatio) const;
+
+        /// <summary>
+        /// Evict least recently used resources not used by frames in flight. Resources sharing memory are
+        /// evicted together when none of them was used recently.
+        /// </summary>
+        /// <param name="bytes"> Bytes to release</param>
+        /// <returns> Bytes released</returns>
+        VkDeviceSize EvictLeastRecentlyUsed(VkDeviceSize bytes);
+
+        Device& device;
+        uint32_t framesInFlight;
+        uint64_t currentFrame = 0;
+        // Freed memory shows in budget once frames in flight finish, no eviction is done until then.
+        uint64_t nextEvictionFrame = 0;
+        std::vector<std::weak_ptr<EvictableResource>> resources;
+        Statistics statistics;
+    };
+}
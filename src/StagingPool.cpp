@@ -0,0 +1,59 @@
+#include "StagingPool.hpp"
+
+namespace VulkanEngine
+{
+    StagingPool::StagingPool(Device& device, VkDeviceSize maxCachedBytes):
+        device(device),
+        maxCachedBytes(maxCachedBytes)
+    {
+    }
+
+    uint32_t StagingPool::SizeClass(VkDeviceSize size)
+    {
+        uint32_t sizeClass = 0;
+        while (sizeClass < CLASS_COUNT && ClassSize(sizeClass) < size)
+        {
+            sizeClass++;
+        }
+        return sizeClass;
+    }
+
+    std::unique_ptr<Buffer> StagingPool::Acquire(VkDeviceSize size)
+    {
+        statistics.acquired++;
+
+        uint32_t sizeClass = SizeClass(size);
+        if (sizeClass < CLASS_COUNT && !freeBuffers[sizeClass].empty())
+        {
+            auto buffer = std::move(freeBuffers[sizeClass].back());
+            freeBuffers[sizeClass].pop_back();
+            statistics.cachedBytes -= buffer->GetBufferSize();
+            return buffer;
+        }
+
+        statistics.created++;
+        auto buffer = std::make_unique<Buffer>(
+            device,
+            sizeClass < CLASS_COUNT ? ClassSize(sizeClass) : size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        // Stays mapped for whole lifetime
+        buffer->Map();
+        return buffer;
+    }
+
+    void StagingPool::Recycle(std::unique_ptr<Buffer> buffer)
+    {
+        VkDeviceSize size = buffer->GetBufferSize();
+        uint32_t sizeClass = SizeClass(size);
+        if (sizeClass == CLASS_COUNT || ClassSize(sizeClass) != size ||
+            statistics.cachedBytes + size > maxCachedBytes)
+        {
+            // Destroyed here
+            return;
+        }
+        statistics.cachedBytes += size;
+        freeBuffers[sizeClass].push_back(std::move(buffer));
+    }
+}
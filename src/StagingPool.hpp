@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Cache of persistently mapped staging buffers in power of two size classes. Upload context takes buffer
+    /// for batch and gives it back once fence of batch signals, so steady streaming creates no buffers.
+    /// Not thread safe, owner synchronizes access.
+    /// </summary>
+    class StagingPool
+    {
+    public:
+        static constexpr VkDeviceSize MIN_CLASS_SIZE = 256ull * 1024;
+        // 256 KB .. 64 MB, bigger requests get exact size buffer which isn't cached
+        static constexpr uint32_t CLASS_COUNT = 9;
+        static constexpr VkDeviceSize DEFAULT_CACHE_SIZE = 128ull * 1024 * 1024;
+
+        struct Statistics
+        {
+            uint64_t acquired = 0;
+            // Buffers which had to be created, rest was reused
+            uint64_t created = 0;
+            VkDeviceSize cachedBytes = 0;
+        };
+
+        /// <summary>
+        /// Create empty pool.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="maxCachedBytes"> Free buffers above this size are destroyed, 0 disables caching</param>
+        StagingPool(Device& device, VkDeviceSize maxCachedBytes = DEFAULT_CACHE_SIZE);
+
+        StagingPool(const StagingPool&) = delete;
+        StagingPool& operator=(const StagingPool&) = delete;
+
+        /// <summary>
+        /// Get mapped staging buffer of at least given size.
+        /// </summary>
+        /// <param name="size"> Required size in bytes</param>
+        /// <returns> Buffer with size of its size class</returns>
+        std::unique_ptr<Buffer> Acquire(VkDeviceSize size);
+
+        /// <summary>
+        /// Return buffer which GPU doesn't use anymore.
+        /// </summary>
+        /// <param name="buffer"> Buffer from Acquire</param>
+        void Recycle(std::unique_ptr<Buffer> buffer);
+
+        const Statistics& GetStatistics() const
+        {
+            return statistics;
+        }
+
+    private:
+        /// <summary>
+        /// Index of smallest class fitting size, CLASS_COUNT if there is none.
+        /// </summary>
+        static uint32_t SizeClass(VkDeviceSize size);
+
+        static VkDeviceSize ClassSize(uint32_t sizeClass)
+        {
+            return MIN_CLASS_SIZE << sizeClass;
+        }
+
+        Device& device;
+        VkDeviceSize maxCachedBytes;
+        std::array<std::vector<std::unique_ptr<Buffer>>, CLASS_COUNT> freeBuffers;
+        Statistics statistics;
+    };
+}
@@ -10,6 +10,7 @@
 #include <stdexcept>
 
 #include "Image.hpp"
+#include "Profiler.hpp"
 
 namespace VulkanEngine
 {
@@ -56,7 +57,7 @@ namespace VulkanEngine
         {
             vkDestroyImageView(device.GetDevice(), depthImageViews[i], nullptr);
             vkDestroyImage(device.GetDevice(), depthImages[i], nullptr);
-            vkFreeMemory(device.GetDevice(), depthImageMemorys[i], nullptr);
+            device.FreeMemory(depthImageMemorys[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers)
@@ -77,6 +78,7 @@ namespace VulkanEngine
 
     VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
     {
+        PROFILE_SCOPE("SwapChain::AcquireNextImage");
         vkWaitForFences(
             device.GetDevice(),
             1,
@@ -98,6 +100,7 @@ namespace VulkanEngine
     VkResult SwapChain::SubmitCommandBuffers(
         const VkCommandBuffer* buffers, uint32_t* imageIndex)
     {
+        PROFILE_SCOPE("SwapChain::SubmitCommandBuffers");
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
         {
             vkWaitForFences(device.GetDevice(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
@@ -428,9 +431,6 @@ namespace VulkanEngine
 
     VkFormat SwapChain::FindDepthFormat()
     {
-        return device.FindSupportedFormat(
-            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        return device.FindDepthFormat();
     }
 }
@@ -1,11 +1,21 @@
 #pragma once
 #include "Terrain.hpp"
+#include "Profiler.hpp"
+#include "MeshOptimizer.hpp"
 #include <glm/gtc/noise.hpp>
 
 namespace VulkanEngine
 {
     // Function to generate a terrain. Terrain heightmap is generated using Perlin noise.
     std::unique_ptr<Model> Terrain::Generate(Device& device, int points)
+    {
+        PROFILE_SCOPE("Terrain::Generate");
+        Model::ModelData modelData = GenerateData(points);
+        MeshOptimizer::Optimize(modelData);
+        return std::make_unique<Model>(device, modelData);
+    }
+
+    Model::ModelData Terrain::GenerateData(int points)
     {
         VulkanEngine::Model::ModelData modelData = {};
         auto divider = 1.f / points;
@@ -73,6 +83,7 @@ namespace VulkanEngine
             }
         }
 
-        return std::make_unique<Model>(device, modelData);
+        modelData.ComputeBounds();
+        return modelData;
     }
 }
@@ -16,5 +16,12 @@ namespace VulkanEngine
         /// <param name="points"> number of points, total number of vertex will be points^2</param>
         /// <returns> unique_ptr<Model> generated model</returns>
         static std::unique_ptr<Model> Generate(Device& device, int points);
+
+        /// <summary>
+        /// Generate mesh of terrain without creating model, triangles are in row order.
+        /// </summary>
+        /// <param name="points"> number of points, total number of vertex will be points^2</param>
+        /// <returns> Generated mesh</returns>
+        static Model::ModelData GenerateData(int points);
     };
 }
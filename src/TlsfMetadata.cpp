@@ -0,0 +1,300 @@
+#include "TlsfMetadata.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace VulkanEngine
+{
+    // Index of highest set bit, value must not be 0.
+    static uint32_t MostSignificantBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+    // Index of lowest set bit, value must not be 0.
+    static uint32_t LeastSignificantBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    TlsfMetadata::TlsfMetadata(uint64_t size):
+        size(size)
+    {
+        freeLists.fill(INVALID_HANDLE);
+
+        uint32_t region = CreateRegion();
+        regions[region].offset = 0;
+        regions[region].size = size;
+        InsertFree(region);
+    }
+
+    void TlsfMetadata::MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        firstLevel = MostSignificantBit(size);
+        // Small sizes don't have enough bits for all second level lists, so they use only first one.
+        if (firstLevel < SL_COUNT_LOG2)
+        {
+            secondLevel = 0;
+        }
+        else
+        {
+            secondLevel = static_cast<uint32_t>(size >> (firstLevel - SL_COUNT_LOG2)) & (SL_COUNT - 1);
+        }
+    }
+
+    uint32_t TlsfMetadata::FindFreeRegion(uint64_t size) const
+    {
+        // Round size up to next list, so any region of found list is big enough.
+        uint32_t firstLevel = MostSignificantBit(size);
+        if (firstLevel >= SL_COUNT_LOG2)
+        {
+            size += (1ull << (firstLevel - SL_COUNT_LOG2)) - 1;
+        }
+        else if (size != 1ull << firstLevel)
+        {
+            size = 1ull << (firstLevel + 1);
+        }
+
+        uint32_t secondLevel;
+        MapSize(size, firstLevel, secondLevel);
+
+        uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+        if (secondLevelMap == 0)
+        {
+            uint64_t firstLevelMap = firstLevel + 1 < FL_COUNT ? firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+            if (firstLevelMap == 0)
+            {
+                return INVALID_HANDLE;
+            }
+            firstLevel = LeastSignificantBit(firstLevelMap);
+            secondLevelMap = secondLevelBitmaps[firstLevel];
+        }
+        secondLevel = LeastSignificantBit(secondLevelMap);
+        return freeLists[firstLevel * SL_COUNT + secondLevel];
+    }
+
+    bool TlsfMetadata::Allocate(uint64_t size, uint64_t alignment, Allocation& allocation)
+    {
+        assert(size > 0);
+        alignment = std::max<uint64_t>(alignment, 1);
+        assert((alignment & (alignment - 1)) == 0);
+
+        // Region found for exact size usually is aligned already, if not, search again with space for alignment.
+        uint32_t region = FindFreeRegion(size);
+        if (region != INVALID_HANDLE)
+        {
+            const Region& candidate = regions[region];
+            if (AlignUp(candidate.offset, alignment) + size > candidate.offset + candidate.size)
+            {
+                region = INVALID_HANDLE;
+            }
+        }
+        if (region == INVALID_HANDLE && alignment > 1)
+        {
+            region = FindFreeRegion(size + alignment - 1);
+        }
+        if (region == INVALID_HANDLE)
+        {
+            return false;
+        }
+
+        RemoveFree(region);
+        uint64_t offset = AlignUp(regions[region].offset, alignment);
+        Split(region, offset, size);
+
+        usedBytes += size;
+        allocationCount++;
+
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.handle = region;
+        return true;
+    }
+
+    void TlsfMetadata::Free(uint32_t handle)
+    {
+        assert(handle < regions.size() && !regions[handle].free);
+        usedBytes -= regions[handle].size;
+        allocationCount--;
+
+        // Merge with previous region
+        uint32_t prev = regions[handle].prevPhysical;
+        if (prev != INVALID_HANDLE && regions[prev].free)
+        {
+            RemoveFree(prev);
+            regions[prev].size += regions[handle].size;
+            regions[prev].nextPhysical = regions[handle].nextPhysical;
+            if (regions[handle].nextPhysical != INVALID_HANDLE)
+            {
+                regions[regions[handle].nextPhysical].prevPhysical = prev;
+            }
+            ReleaseRegion(handle);
+            handle = prev;
+        }
+
+        // Merge with next region
+        uint32_t next = regions[handle].nextPhysical;
+        if (next != INVALID_HANDLE && regions[next].free)
+        {
+            RemoveFree(next);
+            regions[handle].size += regions[next].size;
+            regions[handle].nextPhysical = regions[next].nextPhysical;
+            if (regions[next].nextPhysical != INVALID_HANDLE)
+            {
+                regions[regions[next].nextPhysical].prevPhysical = handle;
+            }
+            ReleaseRegion(next);
+        }
+
+        InsertFree(handle);
+    }
+
+    TlsfMetadata::Statistics TlsfMetadata::GetStatistics() const
+    {
+        Statistics statistics{};
+        statistics.size = size;
+        statistics.usedBytes = usedBytes;
+        statistics.freeBytes = size - usedBytes;
+        statistics.allocationCount = allocationCount;
+        for (uint32_t head : freeLists)
+        {
+            for (uint32_t region = head; region != INVALID_HANDLE; region = regions[region].nextFree)
+            {
+                statistics.freeRegionCount++;
+                statistics.largestFreeRegion = std::max(statistics.largestFreeRegion, regions[region].size);
+            }
+        }
+        return statistics;
+    }
+
+    uint32_t TlsfMetadata::CreateRegion()
+    {
+        if (!unusedRegions.empty())
+        {
+            uint32_t region = unusedRegions.back();
+            unusedRegions.pop_back();
+            regions[region] = Region{};
+            return region;
+        }
+        regions.emplace_back();
+        return static_cast<uint32_t>(regions.size() - 1);
+    }
+
+    void TlsfMetadata::ReleaseRegion(uint32_t region)
+    {
+        regions[region] = Region{};
+        unusedRegions.push_back(region);
+    }
+
+    void TlsfMetadata::InsertFree(uint32_t region)
+    {
+        uint32_t firstLevel, secondLevel;
+        MapSize(regions[region].size, firstLevel, secondLevel);
+        uint32_t& head = freeLists[firstLevel * SL_COUNT + secondLevel];
+
+        regions[region].free = true;
+        regions[region].prevFree = INVALID_HANDLE;
+        regions[region].nextFree = head;
+        if (head != INVALID_HANDLE)
+        {
+            regions[head].prevFree = region;
+        }
+        head = region;
+
+        secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+        firstLevelBitmap |= 1ull << firstLevel;
+    }
+
+    void TlsfMetadata::RemoveFree(uint32_t region)
+    {
+        uint32_t firstLevel, secondLevel;
+        MapSize(regions[region].size, firstLevel, secondLevel);
+        uint32_t& head = freeLists[firstLevel * SL_COUNT + secondLevel];
+
+        Region& removed = regions[region];
+        if (removed.prevFree != INVALID_HANDLE)
+        {
+            regions[removed.prevFree].nextFree = removed.nextFree;
+        }
+        if (removed.nextFree != INVALID_HANDLE)
+        {
+            regions[removed.nextFree].prevFree = removed.prevFree;
+        }
+        if (head == region)
+        {
+            head = removed.nextFree;
+            if (head == INVALID_HANDLE)
+            {
+                secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+                if (secondLevelBitmaps[firstLevel] == 0)
+                {
+                    firstLevelBitmap &= ~(1ull << firstLevel);
+                }
+            }
+        }
+        removed.free = false;
+        removed.prevFree = INVALID_HANDLE;
+        removed.nextFree = INVALID_HANDLE;
+    }
+
+    void TlsfMetadata::Split(uint32_t region, uint64_t offset, uint64_t size)
+    {
+        // Neighbours of free region are never free, so new free regions don't need merging.
+        // Regions are accessed by index, because creating region may reallocate vector.
+        uint64_t padding = offset - regions[region].offset;
+        if (padding > 0)
+        {
+            uint32_t front = CreateRegion();
+            regions[front].offset = regions[region].offset;
+            regions[front].size = padding;
+            regions[front].prevPhysical = regions[region].prevPhysical;
+            regions[front].nextPhysical = region;
+            if (regions[region].prevPhysical != INVALID_HANDLE)
+            {
+                regions[regions[region].prevPhysical].nextPhysical = front;
+            }
+            regions[region].prevPhysical = front;
+            regions[region].offset = offset;
+            regions[region].size -= padding;
+            InsertFree(front);
+        }
+
+        uint64_t remaining = regions[region].size - size;
+        if (remaining > 0)
+        {
+            uint32_t back = CreateRegion();
+            regions[back].offset = offset + size;
+            regions[back].size = remaining;
+            regions[back].prevPhysical = region;
+            regions[back].nextPhysical = regions[region].nextPhysical;
+            if (regions[region].nextPhysical != INVALID_HANDLE)
+            {
+                regions[regions[region].nextPhysical].prevPhysical = back;
+            }
+            regions[region].nextPhysical = back;
+            regions[region].size = size;
+            InsertFree(back);
+        }
+    }
+}
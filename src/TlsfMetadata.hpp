@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Two-level segregated fit (TLSF) bookkeeping of one memory block. It only manages offsets,
+    /// so it knows nothing about Vulkan. Allocation and free are O(1): free regions are kept in
+    /// lists by size class, non-empty lists are found with bitmaps and neighbours are merged on free.
+    /// </summary>
+    class TlsfMetadata
+    {
+    public:
+        static constexpr uint32_t INVALID_HANDLE = ~0u;
+
+        /// <summary>
+        /// Sub-allocated region.
+        /// </summary>
+        struct Allocation
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t handle = INVALID_HANDLE;
+        };
+
+        /// <summary>
+        /// Fragmentation statistics of block.
+        /// </summary>
+        struct Statistics
+        {
+            uint64_t size = 0;
+            uint64_t usedBytes = 0;
+            uint64_t freeBytes = 0;
+            uint64_t largestFreeRegion = 0;
+            uint32_t allocationCount = 0;
+            uint32_t freeRegionCount = 0;
+        };
+
+        /// <summary>
+        /// Create metadata of empty block.
+        /// </summary>
+        /// <param name="size"> Size of managed block in bytes</param>
+        TlsfMetadata(uint64_t size);
+
+        /// <summary>
+        /// Find free region for allocation.
+        /// </summary>
+        /// <param name="size"> Requested size in bytes</param>
+        /// <param name="alignment"> Required alignment of offset, power of two</param>
+        /// <param name="allocation"> Filled with allocated region</param>
+        /// <returns> false if block has no free region big enough</returns>
+        bool Allocate(uint64_t size, uint64_t alignment, Allocation& allocation);
+
+        /// <summary>
+        /// Return region to block, merging it with free neighbours.
+        /// </summary>
+        /// <param name="handle"> Handle of allocation</param>
+        void Free(uint32_t handle);
+
+        bool IsEmpty() const
+        {
+            return allocationCount == 0;
+        }
+
+        uint64_t GetSize() const
+        {
+            return size;
+        }
+
+        Statistics GetStatistics() const;
+
+    private:
+        static constexpr uint32_t SL_COUNT_LOG2 = 4;
+        static constexpr uint32_t SL_COUNT = 1u << SL_COUNT_LOG2;
+        static constexpr uint32_t FL_COUNT = 64;
+
+        struct Region
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = INVALID_HANDLE;
+            uint32_t nextPhysical = INVALID_HANDLE;
+            uint32_t prevFree = INVALID_HANDLE;
+            uint32_t nextFree = INVALID_HANDLE;
+            bool free = false;
+        };
+
+        static void MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+        /// <summary>
+        /// Find free region from list which guarantees fit of given size.
+        /// </summary>
+        /// <returns> Region handle or INVALID_HANDLE</returns>
+        uint32_t FindFreeRegion(uint64_t size) const;
+
+        uint32_t CreateRegion();
+        void ReleaseRegion(uint32_t region);
+        void InsertFree(uint32_t region);
+        void RemoveFree(uint32_t region);
+
+        /// <summary>
+        /// Split free space before and after allocated part of region to new free regions.
+        /// </summary>
+        void Split(uint32_t region, uint64_t offset, uint64_t size);
+
+        uint64_t size;
+        uint64_t usedBytes = 0;
+        uint32_t allocationCount = 0;
+
+        std::vector<Region> regions;
+        std::vector<uint32_t> unusedRegions;
+
+        uint64_t firstLevelBitmap = 0;
+        std::array<uint32_t, FL_COUNT> secondLevelBitmaps{};
+        std::array<uint32_t, FL_COUNT * SL_COUNT> freeLists;
+    };
+}
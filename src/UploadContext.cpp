@@ -0,0 +1,473 @@
+#include "UploadContext.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "Profiler.hpp"
+
+namespace VulkanEngine
+{
+    static VkCommandPool CreateUploadCommandPool(VkDevice device, uint32_t queueFamily)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        VkCommandPool commandPool;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+        return commandPool;
+    }
+
+    static VkCommandBuffer AllocateUploadCommandBuffer(VkDevice device, VkCommandPool commandPool)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+        return commandBuffer;
+    }
+
+    static VkFence CreateUploadFence(VkDevice device)
+    {
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+        return fence;
+    }
+
+    static void BeginUploadCommandBuffer(VkCommandBuffer commandBuffer)
+    {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording upload command buffer!");
+        }
+    }
+
+    static VkDeviceSize GetTexelSize(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R16_SFLOAT:
+            return 2;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_B8G8R8_SRGB:
+            return 3;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            throw std::runtime_error("failed to upload image of unsupported format!");
+        }
+    }
+
+    // Everything uploaded can be read by these accesses
+    static constexpr VkAccessFlags UPLOAD_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+        VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    static constexpr VkPipelineStageFlags UPLOAD_READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    UploadContext::UploadContext(Device& device, VkDeviceSize stagingCacheSize):
+        device(device),
+        dedicatedTransfer(device.HasDedicatedTransferQueue()),
+        stagingPool(device, stagingCacheSize)
+    {
+        commandPool = CreateUploadCommandPool(device.GetDevice(), device.TransferQueueFamily());
+        if (dedicatedTransfer)
+        {
+            acquireCommandPool = CreateUploadCommandPool(device.GetDevice(), device.GraphicsQueueFamily());
+        }
+    }
+
+    UploadContext::~UploadContext()
+    {
+        WaitAll();
+
+        // Recording batch was submitted by WaitAll, so all batches are free now.
+        for (auto& batch : freeBatches)
+        {
+            vkDestroyFence(device.GetDevice(), batch->fence, nullptr);
+            if (dedicatedTransfer)
+            {
+                vkDestroyFence(device.GetDevice(), batch->transferFence, nullptr);
+                vkDestroySemaphore(device.GetDevice(), batch->transferSemaphore, nullptr);
+            }
+        }
+        if (dedicatedTransfer)
+        {
+            vkDestroyCommandPool(device.GetDevice(), acquireCommandPool, nullptr);
+        }
+        vkDestroyCommandPool(device.GetDevice(), commandPool, nullptr);
+    }
+
+    UploadContext::Batch& UploadContext::GetRecordingBatch()
+    {
+        if (recording)
+        {
+            return *recording;
+        }
+
+        if (!freeBatches.empty())
+        {
+            recording = std::move(freeBatches.back());
+            freeBatches.pop_back();
+        }
+        else
+        {
+            recording = std::make_unique<Batch>();
+            recording->commandBuffer = AllocateUploadCommandBuffer(device.GetDevice(), commandPool);
+            recording->fence = CreateUploadFence(device.GetDevice());
+
+            if (dedicatedTransfer)
+            {
+                recording->acquireCommandBuffer = AllocateUploadCommandBuffer(device.GetDevice(), acquireCommandPool);
+                recording->transferFence = CreateUploadFence(device.GetDevice());
+
+                VkSemaphoreCreateInfo semaphoreInfo{};
+                semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                if (vkCreateSemaphore(device.GetDevice(), &semaphoreInfo, nullptr, &recording->transferSemaphore) !=
+                    VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create upload semaphore!");
+                }
+            }
+        }
+
+        BeginUploadCommandBuffer(recording->commandBuffer);
+        return *recording;
+    }
+
+    UploadContext::StagingRange UploadContext::WriteStaging(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+    {
+        Batch& batch = GetRecordingBatch();
+        VkDeviceSize offset = (batch.stagingOffset + alignment - 1) / alignment * alignment;
+        if (batch.stagingBuffers.empty() || offset + size > batch.stagingBuffers.back()->GetBufferSize())
+        {
+            batch.stagingBuffers.push_back(stagingPool.Acquire(size));
+            offset = 0;
+        }
+
+        Buffer& staging = *batch.stagingBuffers.back();
+        staging.WriteToBuffer(const_cast<void*>(data), size, offset);
+        batch.stagingOffset = offset + size;
+        return {staging.GetBuffer(), offset};
+    }
+
+    UploadToken UploadContext::UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        StagingRange staging = WriteStaging(data, size, STAGING_ALIGNMENT);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = staging.offset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(recording->commandBuffer, staging.buffer, dstBuffer, 1, &copyRegion);
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+        recording->bufferBarriers.push_back(barrier);
+        return lastSubmitted + 1;
+    }
+
+    UploadToken UploadContext::UploadImage(const void* data, VkDeviceSize size, VkImage image, VkFormat format,
+                                    uint32_t width, uint32_t height, VkImageSubresourceRange subresourceRange)
+    {
+        // Buffer offset of image copy must be multiple of texel size, which isn't power of two for 3 byte
+        // formats, so least common multiple satisfies all requirements at once
+        VkDeviceSize alignment = std::lcm(std::lcm(STAGING_ALIGNMENT, GetTexelSize(format)),
+            std::max<VkDeviceSize>(device.properties.limits.optimalBufferCopyOffsetAlignment, 1));
+
+        std::lock_guard<std::mutex> lock{mutex};
+        StagingRange staging = WriteStaging(data, size, alignment);
+        VkCommandBuffer commandBuffer = recording->commandBuffer;
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = subresourceRange;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = staging.offset;
+        region.imageSubresource.aspectMask = subresourceRange.aspectMask;
+        region.imageSubresource.mipLevel = subresourceRange.baseMipLevel;
+        region.imageSubresource.baseArrayLayer = subresourceRange.baseArrayLayer;
+        region.imageSubresource.layerCount = subresourceRange.layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+        vkCmdCopyBufferToImage(commandBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // Transition to shader read only is recorded at submit, together with ownership transfer if needed.
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        recording->imageBarriers.push_back(barrier);
+        return lastSubmitted + 1;
+    }
+
+    void UploadContext::RecordOwnershipTransfer(Batch& batch)
+    {
+        // Release and acquire must have same families, ranges and layouts, they differ only in access masks.
+        for (auto& barrier : batch.bufferBarriers)
+        {
+            barrier.srcQueueFamilyIndex = device.TransferQueueFamily();
+            barrier.dstQueueFamilyIndex = device.GraphicsQueueFamily();
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+        }
+        for (auto& barrier : batch.imageBarriers)
+        {
+            barrier.srcQueueFamilyIndex = device.TransferQueueFamily();
+            barrier.dstQueueFamilyIndex = device.GraphicsQueueFamily();
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+        }
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr,
+                             static_cast<uint32_t>(batch.bufferBarriers.size()), batch.bufferBarriers.data(),
+                             static_cast<uint32_t>(batch.imageBarriers.size()), batch.imageBarriers.data());
+
+        for (auto& barrier : batch.bufferBarriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+        }
+        for (auto& barrier : batch.imageBarriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+        BeginUploadCommandBuffer(batch.acquireCommandBuffer);
+        // Source stage matches semaphore wait stage, so acquire happens after copies.
+        vkCmdPipelineBarrier(batch.acquireCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, UPLOAD_READ_STAGES,
+                             0, 0, nullptr,
+                             static_cast<uint32_t>(batch.bufferBarriers.size()), batch.bufferBarriers.data(),
+                             static_cast<uint32_t>(batch.imageBarriers.size()), batch.imageBarriers.data());
+        if (vkEndCommandBuffer(batch.acquireCommandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record upload acquire command buffer!");
+        }
+    }
+
+    UploadToken UploadContext::Submit()
+    {
+        PROFILE_SCOPE("UploadContext::Submit");
+        std::lock_guard<std::mutex> lock{mutex};
+        return SubmitLocked();
+    }
+
+    UploadToken UploadContext::SubmitLocked()
+    {
+        if (!recording)
+        {
+            return lastSubmitted;
+        }
+
+        if (dedicatedTransfer)
+        {
+            RecordOwnershipTransfer(*recording);
+        }
+        else
+        {
+            // One barrier for whole batch, later work on this queue reads uploaded data without waiting for fence.
+            for (auto& barrier : recording->imageBarriers)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            }
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+            vkCmdPipelineBarrier(recording->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_READ_STAGES, 0,
+                                 1, &barrier, 0, nullptr,
+                                 static_cast<uint32_t>(recording->imageBarriers.size()),
+                                 recording->imageBarriers.data());
+        }
+
+        if (vkEndCommandBuffer(recording->commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record upload command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &recording->commandBuffer;
+        if (dedicatedTransfer)
+        {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &recording->transferSemaphore;
+        }
+        VkFence fence = dedicatedTransfer ? recording->transferFence : recording->fence;
+        if (vkQueueSubmit(device.TransferQueue(), 1, &submitInfo, fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        recording->token = ++lastSubmitted;
+        submitted.push_back(std::move(recording));
+        return lastSubmitted;
+    }
+
+    void UploadContext::SubmitAcquire(Batch& batch)
+    {
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &batch.transferSemaphore;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+        if (vkQueueSubmit(device.GraphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload acquire command buffer!");
+        }
+        batch.acquireSubmitted = true;
+    }
+
+    void UploadContext::CollectLocked()
+    {
+        VkDevice vkDevice = device.GetDevice();
+
+        // Semaphore is already signaled when acquire is submitted, so graphics queue doesn't wait for copies.
+        if (dedicatedTransfer)
+        {
+            for (auto& batch : submitted)
+            {
+                if (batch->acquireSubmitted)
+                {
+                    continue;
+                }
+                if (vkGetFenceStatus(vkDevice, batch->transferFence) != VK_SUCCESS)
+                {
+                    break;
+                }
+                SubmitAcquire(*batch);
+            }
+        }
+
+        // Batches finish in submission order, so first unfinished one ends the search.
+        while (!submitted.empty() && (!dedicatedTransfer || submitted.front()->acquireSubmitted) &&
+            vkGetFenceStatus(vkDevice, submitted.front()->fence) == VK_SUCCESS)
+        {
+            auto batch = std::move(submitted.front());
+            submitted.pop_front();
+
+            lastCompleted = batch->token;
+            for (auto& staging : batch->stagingBuffers)
+            {
+                stagingPool.Recycle(std::move(staging));
+            }
+            batch->stagingBuffers.clear();
+            batch->stagingOffset = 0;
+            batch->bufferBarriers.clear();
+            batch->imageBarriers.clear();
+            vkResetFences(vkDevice, 1, &batch->fence);
+            vkResetCommandBuffer(batch->commandBuffer, 0);
+            if (dedicatedTransfer)
+            {
+                vkResetFences(vkDevice, 1, &batch->transferFence);
+                vkResetCommandBuffer(batch->acquireCommandBuffer, 0);
+                batch->acquireSubmitted = false;
+            }
+            freeBatches.push_back(std::move(batch));
+        }
+    }
+
+    void UploadContext::Collect()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        CollectLocked();
+    }
+
+    bool UploadContext::IsComplete(UploadToken token)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        CollectLocked();
+        return token <= lastCompleted;
+    }
+
+    void UploadContext::Wait(UploadToken token)
+    {
+        PROFILE_SCOPE("UploadContext::Wait");
+        std::lock_guard<std::mutex> lock{mutex};
+        // Token of batch which is still recorded
+        if (token > lastSubmitted)
+        {
+            SubmitLocked();
+        }
+        CollectLocked();
+        for (auto& batch : submitted)
+        {
+            if (batch->token > token)
+            {
+                break;
+            }
+            if (!batch->acquireSubmitted && dedicatedTransfer)
+            {
+                vkWaitForFences(device.GetDevice(), 1, &batch->transferFence, VK_TRUE, UINT64_MAX);
+                SubmitAcquire(*batch);
+            }
+            vkWaitForFences(device.GetDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+        }
+        CollectLocked();
+    }
+
+    StagingPool::Statistics UploadContext::GetStagingStatistics()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return stagingPool.GetStatistics();
+    }
+
+    void UploadContext::WaitAll()
+    {
+        Wait(Submit());
+    }
+}
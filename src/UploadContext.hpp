@@ -0,0 +1,177 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "StagingPool.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Identifies submitted upload batch.
+    /// </summary>
+    using UploadToken = uint64_t;
+
+    /// <summary>
+    /// Records many uploads and layout transitions into one command buffer, which is submitted with fence
+    /// instead of waiting for queue idle after each copy. Staging buffers are kept until fence of their batch
+    /// signals. Uploads of batch are packed into staging buffers taken from pool, which get them back when fence
+    /// signals.
+    /// Without dedicated transfer queue batch goes to graphics queue and ends with memory barrier, so later
+    /// graphics submissions see uploaded data without waiting for the token.
+    /// With dedicated transfer queue copies run next to rendering. Batch releases ownership of destinations
+    /// on transfer queue and acquires them on graphics queue, which is submitted only after copies finished,
+    /// so graphics queue never waits for them. Destinations may be used once token is complete.
+    /// </summary>
+    class UploadContext
+    {
+    public:
+        /// <summary>
+        /// Create context submitting to transfer queue of device.
+        /// </summary>
+        /// <param name="device"> Current device</param>
+        /// <param name="stagingCacheSize"> Bytes of free staging buffers kept for reuse, 0 disables reuse</param>
+        UploadContext(Device& device, VkDeviceSize stagingCacheSize = StagingPool::DEFAULT_CACHE_SIZE);
+
+        /// <summary>
+        /// Waits for all submitted batches.
+        /// </summary>
+        ~UploadContext();
+
+        UploadContext(const UploadContext&) = delete;
+        UploadContext& operator=(const UploadContext&) = delete;
+
+        /// <summary>
+        /// Copy data to staging buffer and record its copy to destination buffer.
+        /// </summary>
+        /// <param name="data"> Data to upload, can be freed after call</param>
+        /// <param name="size"> Size of data in bytes</param>
+        /// <param name="dstBuffer"> Destination buffer, must have transfer dst usage</param>
+        /// <param name="dstOffset"> Offset in destination buffer</param>
+        /// <returns> Token which batch containing this upload gets when submitted</returns>
+        UploadToken UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+        /// <summary>
+        /// Copy data to staging buffer and record transition of image to transfer destination, copy and
+        /// transition to shader read only layout.
+        /// </summary>
+        /// <param name="data"> Tightly packed texel data of first mip level, can be freed after call</param>
+        /// <param name="size"> Size of data in bytes</param>
+        /// <param name="image"> Destination image in undefined layout, must have transfer dst usage</param>
+        /// <param name="format"> Format of image, staging offset is aligned to its texel size</param>
+        /// <param name="width"> Image width</param>
+        /// <param name="height"> Image height</param>
+        /// <param name="subresourceRange"> Subresource range of image</param>
+        /// <returns> Token which batch containing this upload gets when submitted</returns>
+        /// <exception cref="std::runtime_error"> Format is not uncompressed color format</exception>
+        UploadToken UploadImage(const void* data, VkDeviceSize size, VkImage image, VkFormat format, uint32_t width,
+                         uint32_t height, VkImageSubresourceRange subresourceRange);
+
+        /// <summary>
+        /// Submit recorded batch. Does nothing if there is nothing recorded.
+        /// </summary>
+        /// <returns> Token of submitted batch, or of last batch if nothing was recorded</returns>
+        UploadToken Submit();
+
+        /// <summary>
+        /// Check if batch finished. Releases staging of all finished batches.
+        /// </summary>
+        /// <param name="token"> Token returned by Submit</param>
+        /// <returns> true if batch finished on GPU and its destinations can be used by graphics queue</returns>
+        bool IsComplete(UploadToken token);
+
+        /// <summary>
+        /// Wait until batch finishes on GPU, batch which is still recorded is submitted first.
+        /// </summary>
+        /// <param name="token"> Token returned by Submit</param>
+        void Wait(UploadToken token);
+
+        /// <summary>
+        /// Submit recorded batch and wait for all batches.
+        /// </summary>
+        void WaitAll();
+
+        /// <summary>
+        /// Acquire destinations of batches finished on transfer queue, release staging buffers and command buffers
+        /// of finished batches. Never waits, should be called every frame.
+        /// </summary>
+        void Collect();
+
+        StagingPool::Statistics GetStagingStatistics();
+
+    private:
+        // Minimal offset alignment of copies from staging, image copies are aligned further to texel size
+        // and optimal copy offset of device
+        static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+        struct StagingRange
+        {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+        };
+
+        struct Batch
+        {
+            // Recorded on transfer queue family
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            UploadToken token = 0;
+            // Data is appended to last buffer while it has space
+            std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+            VkDeviceSize stagingOffset = 0;
+            // Written buffer ranges and images waiting for transition to shader read only layout
+            std::vector<VkBufferMemoryBarrier> bufferBarriers;
+            std::vector<VkImageMemoryBarrier> imageBarriers;
+
+            // Used only with dedicated transfer queue. Acquire is recorded on graphics queue family,
+            // fence then signals after acquire, transfer fence after copies.
+            VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+            VkFence transferFence = VK_NULL_HANDLE;
+            VkSemaphore transferSemaphore = VK_NULL_HANDLE;
+            bool acquireSubmitted = false;
+        };
+
+        /// <summary>
+        /// Begin recording batch if none is being recorded.
+        /// </summary>
+        Batch& GetRecordingBatch();
+
+        /// <summary>
+        /// Copy data to staging memory owned by recording batch, at offset which is multiple of alignment.
+        /// </summary>
+        StagingRange WriteStaging(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+
+        /// <summary>
+        /// Record ownership transfer of all destinations of batch, release to transfer command buffer
+        /// and acquire to graphics command buffer.
+        /// </summary>
+        void RecordOwnershipTransfer(Batch& batch);
+
+        /// <summary>
+        /// Submit acquire of batch to graphics queue, after semaphore signaled by copies.
+        /// </summary>
+        void SubmitAcquire(Batch& batch);
+
+        UploadToken SubmitLocked();
+        void CollectLocked();
+
+        Device& device;
+        bool dedicatedTransfer;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandPool acquireCommandPool = VK_NULL_HANDLE;
+        StagingPool stagingPool;
+
+        std::mutex mutex;
+        std::unique_ptr<Batch> recording;
+        // Submitted batches in submission order
+        std::deque<std::unique_ptr<Batch>> submitted;
+        // Finished batches with reset fence and command buffer, ready for reuse
+        std::vector<std::unique_ptr<Batch>> freeBatches;
+
+        UploadToken lastSubmitted = 0;
+        UploadToken lastCompleted = 0;
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cmath>
+#include <limits>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include "Bounds.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Quantize position to 16 bit unorm relative to bounds, decoded as R16G16B16A16_UNORM.
+    /// Scale and offset back to model space are applied by model matrix.
+    /// </summary>
+    /// <param name="position"> Position inside bounds</param>
+    /// <param name="bounds"> Bounds of all positions of mesh</param>
+    /// <returns> Quantized position, w is unused</returns>
+    inline glm::u16vec4 QuantizePosition(const glm::vec3& position, const BoundingBox& bounds)
+    {
+        // Flat mesh has zero extent in some axis, all its positions are at minimum
+        glm::vec3 extent = glm::max(bounds.GetExtent(), glm::vec3{std::numeric_limits<float>::min()});
+        glm::vec3 normalized = glm::clamp((position - bounds.min) / extent, 0.f, 1.f);
+        return glm::u16vec4{glm::round(normalized * 65535.f), 0};
+    }
+
+    /// <summary>
+    /// Encode unit vector with octahedral mapping into two 16 bit snorm values, decoded as R16G16_SNORM.
+    /// Error is below 0.005 degree, which is invisible in lighting.
+    /// </summary>
+    /// <param name="normal"> Normal, zero vector is encoded as +Z</param>
+    /// <returns> Encoded normal</returns>
+    inline glm::i16vec2 EncodeOctahedral(const glm::vec3& normal)
+    {
+        float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (length == 0.f)
+        {
+            return glm::i16vec2{0};
+        }
+
+        // Project to octahedron, lower half is folded over diagonals
+        glm::vec3 projected = normal / length;
+        glm::vec2 encoded{projected.x, projected.y};
+        if (projected.z < 0.f)
+        {
+            encoded = (1.f - glm::abs(glm::vec2{projected.y, projected.x})) *
+                glm::vec2{projected.x >= 0.f ? 1.f : -1.f, projected.y >= 0.f ? 1.f : -1.f};
+        }
+        return glm::i16vec2{glm::round(glm::clamp(encoded, -1.f, 1.f) * 32767.f)};
+    }
+
+    /// <summary>
+    /// Convert texture coordinate to half floats, decoded as R16G16_SFLOAT.
+    /// </summary>
+    inline glm::u16vec2 EncodeHalf(const glm::vec2& value)
+    {
+        return glm::u16vec2{glm::packHalf1x16(value.x), glm::packHalf1x16(value.y)};
+    }
+
+    /// <summary>
+    /// Convert color to 8 bit unorm, decoded as R8G8B8A8_UNORM.
+    /// </summary>
+    inline glm::u8vec4 EncodeColor(const glm::vec3& color)
+    {
+        return glm::u8vec4{glm::round(glm::clamp(color, 0.f, 1.f) * 255.f), 255};
+    }
+}
@@ -0,0 +1,97 @@
+#include "VertexDeduplicator.hpp"
+
+#include <cstring>
+
+namespace VulkanEngine
+{
+    // Vertex must not have padding, its bytes are hashed and compared
+    static_assert(sizeof(Model::Vertex) == 11 * sizeof(float), "vertex must not have padding");
+
+    static constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ull;
+
+    // Final mix of splitmix64, spreads every input bit over all output bits.
+    static uint64_t Mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    static size_t CapacityFor(size_t vertexCount)
+    {
+        // Load factor stays below 3/4
+        size_t capacity = 16;
+        while (capacity * 3 < vertexCount * 4)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    VertexDeduplicator::VertexDeduplicator(size_t expectedVertices):
+        slots(CapacityFor(expectedVertices), EMPTY_SLOT),
+        mask(slots.size() - 1)
+    {
+    }
+
+    uint64_t VertexDeduplicator::Hash(const Model::Vertex& vertex)
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+        uint64_t hash = sizeof(Model::Vertex);
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= sizeof(Model::Vertex); offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            hash = (hash ^ word) * MULTIPLIER;
+            hash ^= hash >> 32;
+        }
+        for (; offset < sizeof(Model::Vertex); offset += sizeof(uint32_t))
+        {
+            uint32_t word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            hash = (hash ^ word) * MULTIPLIER;
+            hash ^= hash >> 32;
+        }
+        return Mix(hash);
+    }
+
+    uint32_t VertexDeduplicator::Insert(const Model::Vertex& vertex, std::vector<Model::Vertex>& vertices)
+    {
+        // Linear probing, first empty slot ends search
+        for (size_t slot = Hash(vertex) & mask;; slot = (slot + 1) & mask)
+        {
+            uint32_t index = slots[slot];
+            if (index == EMPTY_SLOT)
+            {
+                index = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+                slots[slot] = index;
+                if (++count * 4 > slots.size() * 3)
+                {
+                    Grow(vertices);
+                }
+                return index;
+            }
+            if (std::memcmp(&vertices[index], &vertex, sizeof(Model::Vertex)) == 0)
+            {
+                return index;
+            }
+        }
+    }
+
+    void VertexDeduplicator::Grow(const std::vector<Model::Vertex>& vertices)
+    {
+        slots.assign(slots.size() * 2, EMPTY_SLOT);
+        mask = slots.size() - 1;
+        for (uint32_t index = 0; index < vertices.size(); index++)
+        {
+            size_t slot = Hash(vertices[index]) & mask;
+            while (slots[slot] != EMPTY_SLOT)
+            {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = index;
+        }
+    }
+}
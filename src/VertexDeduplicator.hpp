@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Model.hpp"
+
+namespace VulkanEngine
+{
+    /// <summary>
+    /// Flat open addressing hash set of vertices, used to merge identical vertices while building index buffer.
+    /// Slots store indices into vertex array, so vertices are stored only once. Vertices are hashed and compared
+    /// as raw bytes, so -0 and +0 are different vertices.
+    /// </summary>
+    class VertexDeduplicator
+    {
+    public:
+        static constexpr uint32_t EMPTY_SLOT = ~0u;
+
+        /// <summary>
+        /// Create table which holds expected number of vertices without growing.
+        /// </summary>
+        /// <param name="expectedVertices"> Expected number of unique vertices</param>
+        explicit VertexDeduplicator(size_t expectedVertices);
+
+        /// <summary>
+        /// Find vertex or append it to vertices.
+        /// </summary>
+        /// <param name="vertex"> Vertex to find</param>
+        /// <param name="vertices"> Unique vertices, every vertex inserted so far must be in it</param>
+        /// <returns> Index of vertex in vertices</returns>
+        uint32_t Insert(const Model::Vertex& vertex, std::vector<Model::Vertex>& vertices);
+
+        /// <summary>
+        /// Deterministic 64 bit hash of vertex bytes.
+        /// </summary>
+        static uint64_t Hash(const Model::Vertex& vertex);
+
+    private:
+        void Grow(const std::vector<Model::Vertex>& vertices);
+
+        std::vector<uint32_t> slots;
+        size_t mask = 0;
+        size_t count = 0;
+    };
+}
@@ -4,21 +4,78 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 
 #include "App.hpp"
+#include "Profiler.hpp"
 
-int main()
+// Whole argument must be unsigned number fitting uint32_t, std::stoul alone accepts "12abc" and wraps "-1"
+static uint32_t ParseCount(const std::string& value)
 {
-    VulkanEngine::App app{};
+    size_t length = 0;
+    unsigned long count = std::stoul(value, &length);
+    if (value.empty() || value[0] == '-' || length != value.size() || count > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::invalid_argument("invalid count " + value);
+    }
+    return static_cast<uint32_t>(count);
+}
+
+int main(int argc, char* argv[])
+{
+    VulkanEngine::AppConfig config{};
+    std::string traceFile;
+    bool validArguments = true;
+    try
+    {
+        for (int i = 1; i < argc && validArguments; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--headless")
+            {
+                config.headless = true;
+            }
+            else if (arg == "--frames" && i + 1 < argc)
+            {
+                config.frameCount = ParseCount(argv[++i]);
+            }
+            else if (arg == "--trace" && i + 1 < argc)
+            {
+                traceFile = argv[++i];
+            }
+            else
+            {
+                validArguments = false;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        validArguments = false;
+    }
+    if (!validArguments)
+    {
+        std::cerr << "usage: " << argv[0] << " [--headless] [--frames <count>] [--trace <file>]" << '\n';
+        return EXIT_FAILURE;
+    }
+
     try
     {
+        VulkanEngine::App app{config};
         app.run();
+
+        if (!traceFile.empty())
+        {
+            VulkanEngine::Profiler::WriteChromeTrace(traceFile);
+        }
     }
     catch (const std::exception& e)
     {
         std::cerr << e.what() << '\n';
-        return EXIT_SUCCESS;
+        return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;